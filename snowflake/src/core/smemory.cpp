@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <unordered_map>
 
 struct AllocMetaData {
@@ -19,6 +20,8 @@ struct MemoryContext {
 };
 
 static MemoryContext memContext;
+// NOTE: Renderer worker threads allocate too, the allocation table is shared between threads
+static std::mutex memMutex;
 
 void MemoryStartup()
 {
@@ -52,9 +55,6 @@ void* SMalloc(u32 size, MemoryTags tag)
     if (tag == MEMORY_TAG_UNKNOWN) {
         LOG_WARN("SMalloc called using MEMORY_TAG_UNKNOWN. Re-class this allocation");
     }
-
-    memContext.totalAllocated += size;
-    memContext.taggedAllocations[tag] += size;
 #endif
 
     void* block = malloc(size);
@@ -65,6 +65,9 @@ void* SMalloc(u32 size, MemoryTags tag)
     memset(block, 0, size);
 
 #ifdef SNOWFLAKE_MEM_DEBUG
+    std::lock_guard<std::mutex> lock(memMutex);
+    memContext.totalAllocated += size;
+    memContext.taggedAllocations[tag] += size;
     memContext.allocTable.emplace(block, AllocMetaData{ size, tag });
 #endif
 
@@ -76,6 +79,7 @@ void* SRealloc(void* block, u32 size, MemoryTags tag)
     void* newBlk = realloc(block, size);
 
 #ifdef SNOWFLAKE_MEM_DEBUG
+    std::lock_guard<std::mutex> lock(memMutex);
     if (newBlk) {
         if (memContext.allocTable.count(block)) {
             AllocMetaData old = memContext.allocTable.at(block);
@@ -102,6 +106,7 @@ void* SRealloc(void* block, u32 size, MemoryTags tag)
 void SFree(void* block)
 {
 #ifdef SNOWFLAKE_MEM_DEBUG
+    std::unique_lock<std::mutex> lock(memMutex);
     if (memContext.allocTable.count(block)) {
         AllocMetaData metaData = memContext.allocTable.at(block);
         memContext.allocTable.erase(block);
@@ -109,6 +114,7 @@ void SFree(void* block)
         memContext.totalAllocated -= metaData.size;
         memContext.taggedAllocations[metaData.tag] -= metaData.size;
     } else if (block) {
+        lock.unlock();
         LOG_WARN("SFree '%p' allocation is not recorded in AllocTable", block);
     }
 #endif
@@ -152,25 +158,31 @@ char* SMemUsage()
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
+    u64 taggedAllocations[MEMORY_TAG_MAX_TAGS];
+    {
+        std::lock_guard<std::mutex> lock(memMutex);
+        memcpy(taggedAllocations, memContext.taggedAllocations, sizeof(taggedAllocations));
+    }
+
     char buffer[8000] = "System Memory usage (tagged):\n";
     u64 offset = strlen(buffer);
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
         char unit[4] = "xiB";
         f32 amount = 1.0f;
 
-        if (memContext.taggedAllocations[i] >= gib) {
+        if (taggedAllocations[i] >= gib) {
             unit[0] = 'G';
-            amount = (f32) memContext.taggedAllocations[i] / (f32) gib;
-        } else if (memContext.taggedAllocations[i] >= mib) {
+            amount = (f32) taggedAllocations[i] / (f32) gib;
+        } else if (taggedAllocations[i] >= mib) {
             unit[0] = 'M';
-            amount = (f32) memContext.taggedAllocations[i] / (f32) mib;
-        } else if (memContext.taggedAllocations[i] >= kib) {
+            amount = (f32) taggedAllocations[i] / (f32) mib;
+        } else if (taggedAllocations[i] >= kib) {
             unit[0] = 'K';
-            amount = (f32) memContext.taggedAllocations[i] / (f32) kib;
+            amount = (f32) taggedAllocations[i] / (f32) kib;
         } else {
             unit[0] = 'B';
             unit[1] = '\0';
-            amount = (f32) memContext.taggedAllocations[i];
+            amount = (f32) taggedAllocations[i];
         }
 
         i32 len = snprintf(buffer + offset, 8000 - offset, " %s: %.2f%s\n", memoryTagStr[i], amount, unit);
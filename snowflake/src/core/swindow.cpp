@@ -80,6 +80,10 @@ bool8 InitWindow(const char* title, i32 width, i32 height, WindowConfig config)
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     }
 
+    if ((configFlags & FLAG_CONTEXT_OPENGL_DEBUG) > 0) {
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    }
+
     if (config.antialiasingLevel <= 0 || config.antialiasingLevel > 16) {
         LOG_WARN("%d MSAA level not supported, MSAA is default", config.antialiasingLevel);
     } else {
@@ -466,6 +470,7 @@ void EndDrawing()
 
     isDrawing = false;
 
+    RendererEndFrame();
     glfwSwapBuffers((GLFWwindow*) GetGLFWwindowHandle());
 
     snowflake.fps.frameCounter++;
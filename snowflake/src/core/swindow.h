@@ -150,6 +150,7 @@ enum SAPI ConfigFlags {
     FLAG_WINDOW_UNDECORATED = 1 << 3,
     FLAG_CONTEXT_OPENGL_CORE_PROFILE = 1 << 4,
     FLAG_CONTEXT_OPENGL_3 = 1 << 5,
+    FLAG_CONTEXT_OPENGL_DEBUG = 1 << 6,
 };
 
 struct SAPI WindowConfig {
@@ -338,6 +338,18 @@ static inline Vec2 Vector2Invert(const Vec2& v)
     return result;
 }
 
+static inline Vec2 Vector2Min(const Vec2& v1, const Vec2& v2)
+{
+    Vec2 result = { Min(v1.x, v2.x), Min(v1.y, v2.y) };
+    return result;
+}
+
+static inline Vec2 Vector2Max(const Vec2& v1, const Vec2& v2)
+{
+    Vec2 result = { Max(v1.x, v2.x), Max(v1.y, v2.y) };
+    return result;
+}
+
 inline Vec2 operator+(const Vec2& left, const Vec2& right)
 {
     Vec2 result = Vector2Add(left, right);
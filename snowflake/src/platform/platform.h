@@ -2,5 +2,16 @@
 
 #include "core/defines.h"
 
+// NOTE: Read only view of a whole file, handles are only used by the platforms that need them
+struct PlatformFileMapping {
+    const u8* data;
+    u64 size;
+    void* fileHandle;
+    void* mappingHandle;
+};
+
 void PlatformConsoleWrite(const char* msg, u8 color);
-void PlatformConsoleWriteError(const char* message, u8 color);
\ No newline at end of file
+void PlatformConsoleWriteError(const char* message, u8 color);
+
+bool8 PlatformFileMap(const char* filePath, PlatformFileMapping* outMapping);
+void PlatformFileUnmap(PlatformFileMapping* mapping);
\ No newline at end of file
@@ -4,6 +4,10 @@
 #if SPLATFORM_LINUX
 
 #include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 void PlatformConsoleWrite(const char* msg, u8 color)
 {
@@ -19,4 +23,40 @@ void PlatformConsoleWriteError(const char* msg, u8 color)
     fprintf(stderr, "\033[%sm%s\033[0m", colorStrs[color], msg);
 }
 
+bool8 PlatformFileMap(const char* filePath, PlatformFileMapping* outMapping)
+{
+    *outMapping = PlatformFileMapping{ };
+
+    i32 fd = open(filePath, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat fileStat = { };
+    if (fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // NOTE: The mapping keeps the file referenced, the descriptor isn't needed past this point
+    void* data = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    outMapping->data = (const u8*) data;
+    outMapping->size = (u64) fileStat.st_size;
+
+    return true;
+}
+
+void PlatformFileUnmap(PlatformFileMapping* mapping)
+{
+    if (mapping->data) {
+        munmap((void*) mapping->data, (size_t) mapping->size);
+    }
+    *mapping = PlatformFileMapping{ };
+}
+
 #endif
\ No newline at end of file
@@ -29,4 +29,50 @@ void PlatformConsoleWriteError(const char* message, u8 color)
     WriteConsoleA(GetStdHandle(STD_ERROR_HANDLE), message, (DWORD) length, &number_written, 0);
 }
 
+bool8 PlatformFileMap(const char* filePath, PlatformFileMapping* outMapping)
+{
+    *outMapping = PlatformFileMapping{ };
+
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = { };
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    outMapping->data = (const u8*) data;
+    outMapping->size = (u64) fileSize.QuadPart;
+    outMapping->fileHandle = file;
+    outMapping->mappingHandle = mapping;
+
+    return true;
+}
+
+void PlatformFileUnmap(PlatformFileMapping* mapping)
+{
+    if (mapping->data) {
+        UnmapViewOfFile(mapping->data);
+        CloseHandle((HANDLE) mapping->mappingHandle);
+        CloseHandle((HANDLE) mapping->fileHandle);
+    }
+    *mapping = PlatformFileMapping{ };
+}
+
 #endif
\ No newline at end of file
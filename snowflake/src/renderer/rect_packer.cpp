@@ -0,0 +1,182 @@
+#include "rect_packer.h"
+#include "core/sassert.h"
+#include "core/smemory.h"
+
+/*
+    Skyline bottom-left packer, the skyline is the list of segments formed by the top edges of the
+    packed rectangles. Rectangles are placed where they end up lowest, touching the skyline.
+*/
+struct SkylineNode {
+    i32 x;
+    i32 y;
+    i32 width;
+};
+
+struct RectPacker {
+    i32 width;
+    i32 height;
+    i32 usedHeight;
+    SkylineNode* nodes;
+    u32 nodeCount;
+    u32 nodeCapacity;
+};
+
+static i32 RectPackerFit(const RectPacker* packer, u32 index, i32 width, i32 height);
+static void RectPackerInsertNode(RectPacker* packer, u32 index, SkylineNode node);
+
+RectPacker* RectPackerCreate(i32 width, i32 height)
+{
+    SASSERT_MSG(width > 0 && height > 0, "RectPacker size must be greater than 0");
+
+    RectPacker* packer = (RectPacker*) SMalloc(sizeof(RectPacker), MEMORY_TAG_RENDERER);
+    packer->width = width;
+    packer->height = height;
+    packer->nodeCapacity = 16;
+    packer->nodes = (SkylineNode*) SMalloc(packer->nodeCapacity * sizeof(SkylineNode), MEMORY_TAG_RENDERER);
+
+    RectPackerClear(packer);
+
+    return packer;
+}
+
+void RectPackerDelete(RectPacker** packer)
+{
+    if (!packer || !(*packer)) {
+        return;
+    }
+
+    SFree((*packer)->nodes);
+    SFree(*packer);
+    *packer = nullptr;
+}
+
+void RectPackerClear(RectPacker* packer)
+{
+    SASSERT_MSG(packer, "packer can't be null");
+
+    packer->usedHeight = 0;
+    packer->nodeCount = 1;
+    packer->nodes[0] = SkylineNode{ 0, 0, packer->width };
+}
+
+/*
+    Finds room for a width x height rectangle, returns false when it doesn't fit anymore.
+    Packing the rectangles sorted by decreasing height wastes the least space.
+*/
+bool8 RectPackerPack(RectPacker* packer, i32 width, i32 height, Rectanglei* outRect)
+{
+    SASSERT_MSG(packer, "packer can't be null");
+    SASSERT_MSG(outRect, "outRect can't be null");
+    SASSERT_MSG(width >= 0 && height >= 0, "invalid rectangle size");
+
+    if (width == 0 || height == 0) {
+        *outRect = Rectanglei{ 0, 0, width, height };
+        return true;
+    }
+
+    // NOTE: Prefers the lowest top edge and then the narrowest segment to keep the skyline flat
+    u32 bestIndex = packer->nodeCount;
+    i32 bestTop = packer->height + 1;
+    i32 bestWidth = packer->width + 1;
+    for (u32 i = 0; i < packer->nodeCount; i++) {
+        i32 y = RectPackerFit(packer, i, width, height);
+        if (y < 0) {
+            continue;
+        }
+
+        if (y + height < bestTop || (y + height == bestTop && packer->nodes[i].width < bestWidth)) {
+            bestIndex = i;
+            bestTop = y + height;
+            bestWidth = packer->nodes[i].width;
+        }
+    }
+
+    if (bestIndex == packer->nodeCount) {
+        return false;
+    }
+
+    *outRect = Rectanglei{ packer->nodes[bestIndex].x, bestTop - height, width, height };
+    RectPackerInsertNode(packer, bestIndex, SkylineNode{ outRect->left, bestTop, width });
+
+    if (bestTop > packer->usedHeight) {
+        packer->usedHeight = bestTop;
+    }
+
+    return true;
+}
+
+i32 RectPackerGetUsedHeight(const RectPacker* packer)
+{
+    SASSERT_MSG(packer, "packer can't be null");
+    return packer->usedHeight;
+}
+
+/*
+    Returns the y the rectangle rests at when its left edge is placed at the node, -1 if it doesn't fit
+*/
+static i32 RectPackerFit(const RectPacker* packer, u32 index, i32 width, i32 height)
+{
+    i32 x = packer->nodes[index].x;
+    if (x + width > packer->width) {
+        return -1;
+    }
+
+    i32 y = 0;
+    i32 remaining = width;
+    for (u32 i = index; remaining > 0 && i < packer->nodeCount; i++) {
+        if (packer->nodes[i].y > y) {
+            y = packer->nodes[i].y;
+        }
+        remaining -= packer->nodes[i].width;
+    }
+
+    if (y + height > packer->height) {
+        return -1;
+    }
+
+    return y;
+}
+
+static void RectPackerInsertNode(RectPacker* packer, u32 index, SkylineNode node)
+{
+    if (packer->nodeCount + 1 > packer->nodeCapacity) {
+        packer->nodeCapacity *= 2;
+        packer->nodes = (SkylineNode*) SRealloc(packer->nodes, packer->nodeCapacity * sizeof(SkylineNode),
+                                                MEMORY_TAG_RENDERER);
+    }
+
+    SkylineNode* nodes = packer->nodes;
+    SMemMove(nodes + index + 1, nodes + index, (packer->nodeCount - index) * sizeof(SkylineNode));
+    nodes[index] = node;
+    packer->nodeCount++;
+
+    // NOTE: Shrinks or removes the segments now covered by the new node
+    u32 i = index + 1;
+    while (i < packer->nodeCount) {
+        i32 coveredEnd = nodes[i - 1].x + nodes[i - 1].width;
+        if (nodes[i].x >= coveredEnd) {
+            break;
+        }
+
+        i32 shrink = coveredEnd - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+        if (nodes[i].width > 0) {
+            break;
+        }
+
+        SMemMove(nodes + i, nodes + i + 1, (packer->nodeCount - i - 1) * sizeof(SkylineNode));
+        packer->nodeCount--;
+    }
+
+    // NOTE: Merges neighbouring segments at the same height
+    for (u32 j = 0; j + 1 < packer->nodeCount;) {
+        if (nodes[j].y == nodes[j + 1].y) {
+            nodes[j].width += nodes[j + 1].width;
+            SMemMove(nodes + j + 1, nodes + j + 2, (packer->nodeCount - j - 2) * sizeof(SkylineNode));
+            packer->nodeCount--;
+        } else {
+            j++;
+        }
+    }
+}
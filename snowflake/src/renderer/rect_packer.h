@@ -0,0 +1,13 @@
+#pragma once
+
+#include "core/defines.h"
+#include "texture.h"
+
+struct SAPI RectPacker;
+
+SAPI RectPacker* RectPackerCreate(i32 width, i32 height);
+SAPI void RectPackerDelete(RectPacker** packer);
+SAPI void RectPackerClear(RectPacker* packer);
+
+SAPI bool8 RectPackerPack(RectPacker* packer, i32 width, i32 height, Rectanglei* outRect);
+SAPI i32 RectPackerGetUsedHeight(const RectPacker* packer);
@@ -6,6 +6,8 @@
 
 #include <GL/glew.h>
 
+static void DrawCachedGeometry(const CachedGeometry* geometry, Mat4 transformMatrix, Color color);
+
 void ClearBackground(u8 r, u8 g, u8 b, u8 a)
 {
     f32 outR = (f32) r / 255.0f;
@@ -13,6 +15,8 @@ void ClearBackground(u8 r, u8 g, u8 b, u8 a)
     f32 outB = (f32) b / 255.0f;
     f32 outA = (f32) a / 255.0f;
 
+    RendererFlush();
+
     GLCall(glClearColor(outR, outG, outB, outA));
     GLCall(glClear(GL_COLOR_BUFFER_BIT));
 }
@@ -24,83 +28,38 @@ void ClearBackground(Color color)
 
 void DrawPixel(Vec2 pos, Color color)
 {
-    Vertex vertices[] = { { pos, Vector2Zero() } };
-
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
+    Vertex vertices[] = { { pos, Vector2Zero(), color } };
 
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(POINTS, vertices, 1, texture, Matrix4Identity());
-
-    TextureUnload(&texture);
+    RendererDraw(POINTS, vertices, 1, RendererGetDefaultTexture(), Matrix4Identity());
 }
 
 void DrawLine(Vec2 startPos, Vec2 endPos, f32 width, Color color)
 {
     Vertex vertices[] = {
-        { startPos, Vec2{ 0.0f, 0.0f } },
-        { endPos, Vec2{ 1.0f, 0.0f } }
+        { startPos, Vec2{ 0.0f, 0.0f }, color },
+        { endPos, Vec2{ 1.0f, 0.0f }, color }
     };
 
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    GLCall(glLineWidth(width));
+    RendererSetLineWidth(width);
 
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(LINES, vertices, 2, texture, Matrix4Identity());
-
-    TextureUnload(&texture);
+    RendererDraw(LINES, vertices, 2, RendererGetDefaultTexture(), Matrix4Identity());
 }
 
 void DrawTriangle(Vec2 v1, Vec2 v2, Vec2 v3, Color color)
 {
     Vertex vertices[] = {
-        { Vec2{ v1.x, v1.y }, Vector2Zero() },
-        { Vec2{ v2.x, v2.y }, Vector2Zero() },
-        { Vec2{ v3.x, v3.y }, Vector2Zero() }
+        { Vec2{ v1.x, v1.y }, Vector2Zero(), color },
+        { Vec2{ v2.x, v2.y }, Vector2Zero(), color },
+        { Vec2{ v3.x, v3.y }, Vector2Zero(), color }
     };
 
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(TRIANGLES, vertices, 3, texture, Matrix4Identity());
-
-    TextureUnload(&texture);
+    RendererDraw(TRIANGLES, vertices, 3, RendererGetDefaultTexture(), Matrix4Identity());
 }
 
 void DrawCirclePro(Mat4 transformMatrix, i32 pointCount, Color color)
 {
-    i32 vertexCount = (pointCount + 2);
-    i64 verticesSize = vertexCount * sizeof(Vertex);
-    Vertex* vertices = (Vertex*) SAlloca(verticesSize);
-    SMemZero(vertices, verticesSize);
-
-    vertices[0].position.x = 1.0f;
-    vertices[0].position.y = 1.0f;
-
-    const f32 stepAngle = 2 * S_PI32 / (f32) pointCount;
-    for (i32 i = 0; i <= pointCount; i++) {
-        vertices[i + 1].position.x = 1.0f + Cos((f32) i * stepAngle);
-        vertices[i + 1].position.y = 1.0f + Sin((f32) i * stepAngle);
-    }
-
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(TRIANGLE_FAN, vertices, vertexCount, texture, transformMatrix);
-
-    TextureUnload(&texture);
+    SASSERT_MSG(pointCount > 0, "pointCount must be greater than 0");
+    DrawCachedGeometry(RendererGetCircleGeometry(pointCount), transformMatrix, color);
 }
 
 void DrawCircle(Vec2 pos, f32 radius, i32 pointCount, Color color)
@@ -113,29 +72,8 @@ void DrawCircle(Vec2 pos, f32 radius, i32 pointCount, Color color)
 
 void DrawEllipsePro(Mat4 transformMatrix, i32 pointCount, Color color)
 {
-    i32 vertexCount = (pointCount + 2);
-    i64 verticesSize = vertexCount * sizeof(Vertex);
-    Vertex* vertices = (Vertex*) SAlloca(verticesSize);
-    SMemZero(vertices, verticesSize);
-
-    vertices[0].position.x = 1.0f;
-    vertices[0].position.y = 1.0f;
-
-    const f32 stepAngle = 2 * S_PI32 / (f32) pointCount;
-    for (i32 i = 0; i <= pointCount; i++) {
-        vertices[i + 1].position.x = 1.0f + Cos((f32) i * stepAngle);
-        vertices[i + 1].position.y = 1.0f + Sin((f32) i * stepAngle);
-    }
-
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(TRIANGLE_FAN, vertices, vertexCount, texture, transformMatrix);
-
-    TextureUnload(&texture);
+    SASSERT_MSG(pointCount > 0, "pointCount must be greater than 0");
+    DrawCachedGeometry(RendererGetCircleGeometry(pointCount), transformMatrix, color);
 }
 
 void DrawEllipsePro(const EllipseShape* ellipse)
@@ -155,9 +93,7 @@ void DrawEllipse(Vec2 pos, f32 radiusV, f32 radiusH, i32 pointCount, Color color
 
 void DrawRingPro(Mat4 transformMatrix, f32 innerRadius, f32 outerRadius, i32 quadCount, Color color)
 {
-    i64 verticesSize = 6 * quadCount * sizeof(Vertex);
-    Vertex* vertices = (Vertex*) SAlloca(verticesSize);
-    SMemZero(vertices, verticesSize);
+    SASSERT_MSG(quadCount > 0, "quadCount must be greater than 0");
 
     if (outerRadius < innerRadius) {
         f32 tmp = outerRadius;
@@ -165,43 +101,8 @@ void DrawRingPro(Mat4 transformMatrix, f32 innerRadius, f32 outerRadius, i32 qua
         innerRadius = tmp;
     }
 
-    const f32 normalizedInnerRadius = innerRadius / outerRadius;
-    const f32 normalizedOuterRadius = 1.0f;
-    const f32 stepAngle = 2 * S_PI32 / (f32) quadCount;
-    f32 angle = 0.0f;
-    for (i32 i = 0, quadCounter = 0; quadCounter < quadCount; i += 6, quadCounter++) {
-        // First Triangle
-        vertices[i].position.x = 1.0f + Sin(angle) * normalizedInnerRadius;
-        vertices[i].position.y = 1.0f + Cos(angle) * normalizedInnerRadius;
-
-        vertices[i + 1].position.x = 1.0f + Sin(angle) * normalizedOuterRadius;
-        vertices[i + 1].position.y = 1.0f + Cos(angle) * normalizedOuterRadius;
-
-        vertices[i + 2].position.x = 1.0f + Sin(angle + stepAngle) * normalizedInnerRadius;
-        vertices[i + 2].position.y = 1.0f + Cos(angle + stepAngle) * normalizedInnerRadius;
-
-        // Second Triangle
-        vertices[i + 3].position.x = 1.0f + Sin(angle + stepAngle) * normalizedInnerRadius;
-        vertices[i + 3].position.y = 1.0f + Cos(angle + stepAngle) * normalizedInnerRadius;
-
-        vertices[i + 4].position.x = 1.0f + Sin(angle) * normalizedOuterRadius;
-        vertices[i + 4].position.y = 1.0f + Cos(angle) * normalizedOuterRadius;
-
-        vertices[i + 5].position.x = 1.0f + Sin(angle + stepAngle) * normalizedOuterRadius;
-        vertices[i + 5].position.y = 1.0f + Cos(angle + stepAngle) * normalizedOuterRadius;
-
-        angle += stepAngle;
-    }
-
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(TRIANGLES, vertices, 6 * quadCount, texture, transformMatrix);
-
-    TextureUnload(&texture);
+    const CachedGeometry* geometry = RendererGetRingGeometry(quadCount, innerRadius / outerRadius);
+    DrawCachedGeometry(geometry, transformMatrix, color);
 }
 
 void DrawRing(Vec2 pos, f32 innerRadius, f32 outerRadius, i32 quadCount, Color color)
@@ -214,24 +115,22 @@ void DrawRing(Vec2 pos, f32 innerRadius, f32 outerRadius, i32 quadCount, Color c
 
 void DrawRectanglePro(Mat4 transformMatrix, Color color)
 {
+    if (RendererIsInstancingActive()) {
+        RendererDrawInstance(RendererGetQuadMesh(), transformMatrix, Vec4{ 0.0f, 0.0f, 1.0f, 1.0f }, color,
+                             RendererGetDefaultTexture());
+        return;
+    }
+
     Vertex vertices[] = {
-        { Vec2{ 0, 1 }, Vec2{ 0.0f, 1.0f } },
-        { Vec2{ 1, 1 }, Vec2{ 1.0f, 1.0f } },
-        { Vec2{ 0, 0 }, Vec2{ 0.0f, 0.0f } },
-        { Vec2{ 1, 1 }, Vec2{ 1.0f, 1.0f } },
-        { Vec2{ 0, 0 }, Vec2{ 0.0f, 0.0f } },
-        { Vec2{ 1, 0 }, Vec2{ 1.0f, 0.0f } }
+        { Vec2{ 0, 1 }, Vec2{ 0.0f, 1.0f }, color },
+        { Vec2{ 1, 1 }, Vec2{ 1.0f, 1.0f }, color },
+        { Vec2{ 0, 0 }, Vec2{ 0.0f, 0.0f }, color },
+        { Vec2{ 1, 1 }, Vec2{ 1.0f, 1.0f }, color },
+        { Vec2{ 0, 0 }, Vec2{ 0.0f, 0.0f }, color },
+        { Vec2{ 1, 0 }, Vec2{ 1.0f, 0.0f }, color }
     };
 
-    Vec4 colorNormalized = ColorNormalize(color);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
-    Texture2D* texture = TextureCreate(2, 2, WHITE);
-    SASSERT(texture);
-
-    RendererDraw(TRIANGLES, vertices, 6, texture, transformMatrix);
-
-    TextureUnload(&texture);
+    RendererDraw(TRIANGLES, vertices, 6, RendererGetDefaultTexture(), transformMatrix);
 }
 
 void DrawRectangle(Vec2 pos, Vec2 size, f32 rotation, Color color)
@@ -254,18 +153,21 @@ void DrawSpritePro(const Texture2D* texture, Rectanglei texRect, Mat4 transformM
     f32 texCoordBottom = (f32) texRect.top / (f32) textureSize.y;
     f32 texCoordTop = (f32) (texRect.top + texRect.height) / (f32) textureSize.y;
 
+    if (RendererIsInstancingActive()) {
+        Vec4 instanceTexRect = { texCoordLeft, texCoordBottom, texCoordRight, texCoordTop };
+        RendererDrawInstance(RendererGetQuadMesh(), transformMatrix, instanceTexRect, tint, texture);
+        return;
+    }
+
     Vertex vertices[] = {
-        { Vec2{ 0, 1 }, Vec2{ texCoordLeft, texCoordTop } },
-        { Vec2{ 1, 1 }, Vec2{ texCoordRight, texCoordTop } },
-        { Vec2{ 0, 0 }, Vec2{ texCoordLeft, texCoordBottom } },
-        { Vec2{ 1, 1 }, Vec2{ texCoordRight, texCoordTop } },
-        { Vec2{ 0, 0 }, Vec2{ texCoordLeft, texCoordBottom } },
-        { Vec2{ 1, 0 }, Vec2{ texCoordRight, texCoordBottom } }
+        { Vec2{ 0, 1 }, Vec2{ texCoordLeft, texCoordTop }, tint },
+        { Vec2{ 1, 1 }, Vec2{ texCoordRight, texCoordTop }, tint },
+        { Vec2{ 0, 0 }, Vec2{ texCoordLeft, texCoordBottom }, tint },
+        { Vec2{ 1, 1 }, Vec2{ texCoordRight, texCoordTop }, tint },
+        { Vec2{ 0, 0 }, Vec2{ texCoordLeft, texCoordBottom }, tint },
+        { Vec2{ 1, 0 }, Vec2{ texCoordRight, texCoordBottom }, tint }
     };
 
-    Vec4 colorNormalized = ColorNormalize(tint);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
-
     RendererDraw(TRIANGLES, vertices, 6, texture, transformMatrix);
 }
 
@@ -289,4 +191,18 @@ void DrawSprite(const Texture2D* texture, Vec2 pos, f32 rotation, Color tint)
     Transform transform = TransformCreate(Vector3(pos, 0.0f), Vec3{ 0.0f, 0.0f, rotation }, Vector3(textureSize, 1.0f));
     Mat4 transformMatrix = TransformGenerateMatrix(&transform);
     DrawSpritePro(texture, texCoord, transformMatrix, tint);
+}
+
+static void DrawCachedGeometry(const CachedGeometry* geometry, Mat4 transformMatrix, Color color)
+{
+    // NOTE: Cached meshes are only built on the render thread, worker threads batch the vertices
+    if (RendererIsInstancingActive() && RendererIsRenderThread()) {
+        RendererDrawInstance(&geometry->mesh, transformMatrix, Vec4{ 0.0f, 0.0f, 1.0f, 1.0f }, color,
+                             RendererGetDefaultTexture());
+        return;
+    }
+
+    // NOTE: Cached vertices are white, the color is written while batching
+    RendererDraw(geometry->mode, geometry->vertices, geometry->vertexCount, RendererGetDefaultTexture(),
+                 transformMatrix, color);
 }
\ No newline at end of file
@@ -7,24 +7,275 @@
 #include <GL/glew.h>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#define RENDERER_BATCH_MAX_VERTICES (6 * 10000)
+#define RENDERER_BATCH_MAX_INSTANCES 10000
+#define RENDERER_QUEUE_INITIAL_COMMANDS 1024
+#define RENDERER_STREAM_BATCHES_PER_REGION 2
+#define RENDERER_MAX_TEXTURE_SLOTS 32
+#define RENDERER_INSTANCE_FIRST_ATTRIBUTE 4
+#define RENDERER_RING_RATIO_STEPS 4096
+#define GL_STATE_UNKNOWN 0xFFFFFFFF
+
+struct BatchVertex {
+    Vec2 position;
+    Vec2 texCord;
+    Color color;
+    f32 texIndex;
+};
+
+// NOTE: Transform rows are the 2D affine part of the model matrix, texRect holds the min and max UVs
+struct InstanceData {
+    Vec3 transformRow0;
+    Vec3 transformRow1;
+    Vec4 texRect;
+    Color color;
+    f32 texIndex;
+};
+
+enum RenderCommandType {
+    RENDER_COMMAND_VERTICES,
+    RENDER_COMMAND_INSTANCES
+};
+
+/*
+    A draw recorded by the queue, first and count index the queue vertices or instances.
+    Consecutive draws with the same key and state are merged into one command. The shader is copied,
+    so a baked layer keeps the shader that was bound when each draw was recorded.
+*/
+struct RenderCommand {
+    u64 key;
+    u32 type;
+    Shader shader;
+    DrawMode mode;
+    const Mesh* mesh;
+    const Texture2D* texture;
+    BlendMode blendMode;
+    f32 lineWidth;
+    u32 first;
+    u32 count;
+};
+
+// NOTE: What worker threads record against, published by the render thread at EndDrawing()
+struct RenderFrameState {
+    Mat4 viewProjMatrix;
+    bool8 instancing;
+};
+
+/*
+    Worker thread queues are linked through next while pending or free. frameState is the state
+    published when the queue was taken, only worker threads read it.
+*/
+struct RenderQueue {
+    RenderCommand* commands;
+    u32 commandCount;
+    u32 commandCapacity;
+    BatchVertex* vertices;
+    u32 vertexCount;
+    u32 vertexCapacity;
+    InstanceData* instances;
+    u32 instanceCount;
+    u32 instanceCapacity;
+    u64* sortKeys;
+    u32* sortIndices;
+    u32 submittedPrimitives;
+    u32 culledPrimitives;
+    RenderFrameState frameState;
+    RenderQueue* next;
+};
+
+// NOTE: Recording state is kept per thread, so worker threads can set layers without racing the main thread
+struct RenderState {
+    u8 layer;
+    u32 depth;
+    BlendMode blendMode;
+    f32 lineWidth;
+};
+
+// NOTE: vertices and instances point into the mapped stream while the batch is being filled
+struct RenderBatch {
+    VertexArray va;
+    StreamBuffer vertexStream;
+    BatchVertex* vertices;
+    u32 firstVertex;
+    u32 vertexCount;
+    u32 vertexCapacity;
+    DrawMode mode;
+    StreamBuffer instanceStream;
+    InstanceData* instances;
+    u32 firstInstance;
+    u32 instanceCount;
+    u32 instanceCapacity;
+    const Mesh* mesh;
+    u32 type;
+    Shader shader;
+    BlendMode blendMode;
+    f32 lineWidth;
+    const Texture2D* textures[RENDERER_MAX_TEXTURE_SLOTS];
+    u32 textureCount;
+};
+
+// NOTE: Texture indices of the baked vertices refer to the group textures
+struct BakedGroup {
+    const Texture2D* textures[RENDERER_MAX_TEXTURE_SLOTS];
+    u32 textureCount;
+    Shader shader;
+    DrawMode mode;
+    BlendMode blendMode;
+    f32 lineWidth;
+    u32 first;
+    u32 count;
+};
+
+/*
+    Draws recorded between BakedLayerBegin() and BakedLayerEnd(), sorted like the render queue
+    and stored in a static vertex buffer. Consecutive draws sharing state end up in one group.
+*/
+struct BakedLayer {
+    RenderQueue queue;
+    VertexArray va;
+    VertexBuffer vb;
+    BakedGroup* groups;
+    u32 groupCount;
+    u32 vertexCount;
+    bool8 dirty;
+    bool8 recording;
+};
+
+// NOTE: GL_STATE_UNKNOWN forces the next call through, used after startup and when objects are deleted
+struct GLStateCache {
+    u32 program;
+    u32 vertexArray;
+    u32 arrayBuffer;
+    u32 elementArrayBuffer;
+    u32 activeTextureSlot;
+    u32 textures[RENDERER_MAX_TEXTURE_SLOTS];
+    u32 blendEnabled;
+    u32 blendSrcFactor;
+    u32 blendDstFactor;
+    i32 viewport[4];
+    bool8 viewportValid;
+};
 
 struct RendererContext {
     Mat4 projMatrix;
     Mat4 viewMatrix;
+    Mat4 viewProjMatrix;
     Shader boundShader;
+    Shader instanceShader;
+    Shader sdfShader;
     VertexBufferLayout layout;
+    VertexBufferLayout meshLayout;
+    VertexBufferLayout instanceLayout;
+    RenderQueue queue;
+    RenderQueue* pendingQueues;
+    RenderQueue* pendingQueuesTail;
+    RenderQueue* freeQueues;
+    u32 recordingQueueCount;
+    RenderFrameState threadFrameState;
+    RenderBatch batch;
+    Mesh quadMesh;
+    Texture2D* defaultTexture;
+    u32 textureSlotCount;
+    bool8 instancing;
+    GLStateCache glState;
+    RendererStats frameStats;
+    RendererStats lastFrameStats;
 };
 
 static u32 GLGetSizeofType(u32 type);
+static void VertexArraySetAttributes(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout,
+                                     u32 firstAttribute, u32 divisor, u32 offset);
+static void GLDebugStartup();
+#if SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_ASYNC || \
+    SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_SYNC
+static void GLAPIENTRY GLDebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                              GLsizei length, const GLchar* message, const void* userParam);
+#endif
+static void GLStateReset();
+static bool8 GLStateChanged(u32* cached, u32 value);
+
+static void RendererApplyDrawState(Shader shader, const Texture2D* texture, Mat4 mvp);
+static void RendererApplyBlendMode(BlendMode blendMode);
+static void RenderQueueInit(RenderQueue* queue);
+static void RenderQueueDelete(RenderQueue* queue);
+static RenderQueue* RenderQueueGetThreadQueue();
+static void RenderQueueMergePending();
+static void RenderQueuePublishFrameState();
+static bool8 RenderQueueIsBaking();
+static bool8 RenderQueueReferences(const RenderQueue* queue, const Texture2D* texture, const Mesh* mesh);
+static void RendererFlushResource(const Texture2D* texture, const Mesh* mesh, bool8 release);
+static bool8 RenderQueueIsVisible(Vec2 boundsMin, Vec2 boundsMax, Mat4 transformMatrix);
+static u64 RenderQueueGetKey(u32 sequence);
+static void RendererDrawVertices(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
+                                 Mat4 transformMatrix, const Color* color, const Shader* shader);
+static RenderCommand* RenderQueuePushCommand(u32 type, DrawMode mode, const Mesh* mesh, const Texture2D* texture,
+                                             const Shader* shader);
+static void RenderQueueReserveCommands(RenderQueue* queue, u32 commandCount);
+static void RenderQueueReserve(RenderQueue* queue, u32 vertexCount, u32 instanceCount);
+static void RenderQueuePushPrimitive(const Vertex* vertices, const u32* indices, u32 count, Mat4 transformMatrix,
+                                     const Color* color);
+static void RenderQueueSubmitCommand(const RenderCommand* command);
+static void BatchMap();
+static void BatchSubmit();
+static DrawMode BatchGetPrimitiveMode(DrawMode mode);
+static u32 BatchGetPrimitiveSize(DrawMode mode);
+static u32 BatchGetTextureSlot(const Texture2D* texture);
+
+static u64 GeometryCacheKey(u32 type, u32 count, u32 ratio);
+static CachedGeometry* GeometryCacheInsert(u64 key, DrawMode mode, u32 vertexCount);
+static void GeometryCacheBuildMesh(CachedGeometry* geometry);
+static void GeometryCacheClear();
 
 static u32 ShaderCreate(const char* vertexShader, const char* fragmentShader);
 static u32 ShaderCompile(u32 type, const char* source);
-static i32 ShaderGetUniformLocation(Shader shader, const char* uniformName);
+static Shader ShaderLoadBatched(const char* vertexShader, const char* fragmentOutput);
+static Shader ShaderLoadInstanced();
+static Shader ShaderLoadSDF();
+static void ShaderReflectUniforms(Shader* shader);
+static void ShaderInsertUniform(Shader* shader, const char* uniformName, i32 location);
+
+enum GeometryType {
+    GEOMETRY_CIRCLE,
+    GEOMETRY_RING
+};
 
 RendererContext rContext = { };
+static std::unordered_map<u64, CachedGeometry> geometryCache;
+static std::mutex geometryCacheMutex;
+static std::mutex threadQueueMutex;
+static thread_local RenderQueue* threadQueue = nullptr;
+static thread_local RenderState renderState = { 0, 0, BLEND_ALPHA, 1.0f };
+static thread_local bool8 isRenderThread = false;
 Shader defaultShader = { };
 static bool isInit;
 
+// NOTE: Shared by the shaders drawing the batch vertices, they only differ in how the texture is sampled
+static const char* batchVertexShader = R"(
+        #version 330 core
+
+        layout(location = 0) in vec2 aPosition;
+        layout(location = 1) in vec2 aTexCord;
+        layout(location = 2) in vec4 aColor;
+        layout(location = 3) in float aTexIndex;
+
+        out vec2 ourTexCord;
+        out vec4 ourColor;
+        flat out int ourTexIndex;
+
+        uniform mat4 uMvp;
+
+        void main()
+        {
+            gl_Position = uMvp * vec4(aPosition, 0.0f, 1.0f);
+            ourTexCord = aTexCord;
+            ourColor = aColor;
+            ourTexIndex = int(aTexIndex + 0.5f);
+        }
+    )";
+
 void GLClearError()
 {
     while (glGetError() != GL_NO_ERROR);
@@ -91,12 +342,256 @@ static u32 GLGetSizeofType(u32 type)
     return 0;
 }
 
+/*
+    Installs the KHR_debug callback when one of the callback checking levels is selected,
+    the context should be created with FLAG_CONTEXT_OPENGL_DEBUG for drivers to report everything
+*/
+static void GLDebugStartup()
+{
+#if SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_ASYNC || \
+    SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_SYNC
+    if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) {
+        LOG_WARN("KHR_debug is not supported, OpenGL errors won't be reported");
+        return;
+    }
+
+    i32 contextFlags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+    if ((contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0) {
+        LOG_WARN("OpenGL context is not a debug context, some errors may not be reported");
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+#if SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_SYNC
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#else
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+    glDebugMessageCallback(GLDebugMessageCallback, nullptr);
+
+    // NOTE: Notifications are mostly buffer placement hints, they would flood the log every frame
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+
+    LOG_INFO("OpenGL debug output enabled (%s)",
+             (SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_SYNC) ? "synchronous" : "asynchronous");
+#endif
+}
+
+#if SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_ASYNC || \
+    SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_CALLBACK_SYNC
+static void GLAPIENTRY GLDebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                              GLsizei length, const GLchar* message, const void* userParam)
+{
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: {
+            LOG_FATAL("[OpenGL Debug] (ID:%u): %s", id, message);
+            // NOTE: In synchronous mode this breaks inside the failing call
+            SASSERT_MSG(type != GL_DEBUG_TYPE_ERROR, "OpenGL error reported by the debug callback");
+        }
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM: {
+            LOG_ERROR("[OpenGL Debug] (ID:%u): %s", id, message);
+        }
+            break;
+        case GL_DEBUG_SEVERITY_LOW: {
+            LOG_WARN("[OpenGL Debug] (ID:%u): %s", id, message);
+        }
+            break;
+        default: {
+            LOG_DEBUG("[OpenGL Debug] (ID:%u): %s", id, message);
+        }
+            break;
+    }
+}
+#endif
+
+static void GLStateReset()
+{
+    GLStateCache* state = &rContext.glState;
+    state->program = GL_STATE_UNKNOWN;
+    state->vertexArray = GL_STATE_UNKNOWN;
+    state->arrayBuffer = GL_STATE_UNKNOWN;
+    state->elementArrayBuffer = GL_STATE_UNKNOWN;
+    state->activeTextureSlot = GL_STATE_UNKNOWN;
+    for (u32 slot = 0; slot < RENDERER_MAX_TEXTURE_SLOTS; slot++) {
+        state->textures[slot] = GL_STATE_UNKNOWN;
+    }
+    state->blendEnabled = GL_STATE_UNKNOWN;
+    state->blendSrcFactor = GL_STATE_UNKNOWN;
+    state->blendDstFactor = GL_STATE_UNKNOWN;
+    state->viewportValid = false;
+}
+
+/*
+    Updates the cached value and counts the call as issued or elided
+*/
+static bool8 GLStateChanged(u32* cached, u32 value)
+{
+    if (*cached == value) {
+        rContext.frameStats.elidedStateChanges++;
+        return false;
+    }
+
+    *cached = value;
+    rContext.frameStats.stateChanges++;
+    return true;
+}
+
+void GLStateUseProgram(u32 program)
+{
+    if (GLStateChanged(&rContext.glState.program, program)) {
+        GLCall(glUseProgram(program));
+    }
+}
+
+void GLStateBindVertexArray(u32 vertexArray)
+{
+    if (GLStateChanged(&rContext.glState.vertexArray, vertexArray)) {
+        GLCall(glBindVertexArray(vertexArray));
+
+        // NOTE: The element array binding is part of the vertex array state
+        rContext.glState.elementArrayBuffer = GL_STATE_UNKNOWN;
+    }
+}
+
+void GLStateBindBuffer(u32 target, u32 buffer)
+{
+    u32* cached = nullptr;
+    switch (target) {
+        case GL_ARRAY_BUFFER: cached = &rContext.glState.arrayBuffer;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER: cached = &rContext.glState.elementArrayBuffer;
+            break;
+        default: {
+            GLCall(glBindBuffer(target, buffer));
+            return;
+        }
+    }
+
+    if (GLStateChanged(cached, buffer)) {
+        GLCall(glBindBuffer(target, buffer));
+    }
+}
+
+void GLStateBindTexture(u32 texture, u32 slot)
+{
+    if (slot >= RENDERER_MAX_TEXTURE_SLOTS) {
+        GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+        GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+        rContext.glState.activeTextureSlot = slot;
+        return;
+    }
+
+    if (rContext.glState.textures[slot] == texture) {
+        rContext.frameStats.elidedStateChanges++;
+        return;
+    }
+
+    if (GLStateChanged(&rContext.glState.activeTextureSlot, slot)) {
+        GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    }
+
+    rContext.glState.textures[slot] = texture;
+    rContext.frameStats.stateChanges++;
+    GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+}
+
+void GLStateUnbindTexture()
+{
+    u32 slot = rContext.glState.activeTextureSlot;
+    GLStateBindTexture(0, (slot != GL_STATE_UNKNOWN) ? slot : 0);
+}
+
+void GLStateSetBlend(bool8 enabled, u32 srcFactor, u32 dstFactor)
+{
+    GLStateCache* state = &rContext.glState;
+    if (GLStateChanged(&state->blendEnabled, enabled)) {
+        if (enabled) {
+            GLCall(glEnable(GL_BLEND));
+        } else {
+            GLCall(glDisable(GL_BLEND));
+        }
+    }
+
+    if (!enabled) {
+        return;
+    }
+
+    if (state->blendSrcFactor == srcFactor && state->blendDstFactor == dstFactor) {
+        rContext.frameStats.elidedStateChanges++;
+        return;
+    }
+
+    state->blendSrcFactor = srcFactor;
+    state->blendDstFactor = dstFactor;
+    rContext.frameStats.stateChanges++;
+    GLCall(glBlendFunc(srcFactor, dstFactor));
+}
+
+void GLStateSetViewport(i32 x, i32 y, i32 width, i32 height)
+{
+    GLStateCache* state = &rContext.glState;
+    if (state->viewportValid && state->viewport[0] == x && state->viewport[1] == y &&
+        state->viewport[2] == width && state->viewport[3] == height) {
+        rContext.frameStats.elidedStateChanges++;
+        return;
+    }
+
+    state->viewport[0] = x;
+    state->viewport[1] = y;
+    state->viewport[2] = width;
+    state->viewport[3] = height;
+    state->viewportValid = true;
+    rContext.frameStats.stateChanges++;
+    GLCall(glViewport(x, y, width, height));
+}
+
+void GLStateInvalidateProgram(u32 program)
+{
+    if (rContext.glState.program == program) {
+        rContext.glState.program = GL_STATE_UNKNOWN;
+    }
+}
+
+void GLStateInvalidateVertexArray(u32 vertexArray)
+{
+    if (rContext.glState.vertexArray == vertexArray) {
+        rContext.glState.vertexArray = GL_STATE_UNKNOWN;
+        rContext.glState.elementArrayBuffer = GL_STATE_UNKNOWN;
+    }
+}
+
+void GLStateInvalidateBuffer(u32 buffer)
+{
+    if (rContext.glState.arrayBuffer == buffer) {
+        rContext.glState.arrayBuffer = GL_STATE_UNKNOWN;
+    }
+    if (rContext.glState.elementArrayBuffer == buffer) {
+        rContext.glState.elementArrayBuffer = GL_STATE_UNKNOWN;
+    }
+}
+
+void GLStateInvalidateTexture(u32 texture)
+{
+    for (u32 slot = 0; slot < RENDERER_MAX_TEXTURE_SLOTS; slot++) {
+        if (rContext.glState.textures[slot] == texture) {
+            rContext.glState.textures[slot] = GL_STATE_UNKNOWN;
+        }
+    }
+}
+
 void RendererStartup(f32 width, f32 height)
 {
     SASSERT_MSG(isInit == false, "Renderer is already started");
 
-    GLCall(glEnable(GL_BLEND));
-    GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GLDebugStartup();
+    GLStateReset();
+    RendererApplyBlendMode(BLEND_ALPHA);
+
+    i32 maxTextureUnits = 0;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits));
+    rContext.textureSlotCount = (u32) Clamp(maxTextureUnits, 1, RENDERER_MAX_TEXTURE_SLOTS);
+    LOG_INFO("Renderer texture slots: %u", rContext.textureSlotCount);
 
     defaultShader = ShaderLoadDefault();
     ShaderBind(defaultShader);
@@ -106,6 +601,59 @@ void RendererStartup(f32 width, f32 height)
     rContext.layout = VertexBufferLayoutInit();
     VertexBufferLayoutPushVec2(&rContext.layout, 1);
     VertexBufferLayoutPushVec2(&rContext.layout, 1);
+    VertexBufferLayoutPushColor(&rContext.layout, 1);
+    VertexBufferLayoutPushFloat(&rContext.layout, 1);
+
+    // NOTE: Vertex arrays without color or texture index attributes are drawn untinted from slot 0
+    GLCall(glVertexAttrib4f(2, 1.0f, 1.0f, 1.0f, 1.0f));
+    GLCall(glVertexAttrib1f(3, 0.0f));
+
+    RenderBatch* batch = &rContext.batch;
+    batch->vertexCapacity = RENDERER_BATCH_MAX_VERTICES;
+    batch->vertexStream = StreamBufferInit(RENDERER_STREAM_BATCHES_PER_REGION * batch->vertexCapacity *
+                                           sizeof(BatchVertex));
+    batch->va = VertexArrayInit();
+    VertexArrayAddBuffer(batch->va, batch->vertexStream.vb, &rContext.layout);
+
+    rContext.meshLayout = VertexBufferLayoutInit();
+    VertexBufferLayoutPushVec2(&rContext.meshLayout, 1);
+    VertexBufferLayoutPushVec2(&rContext.meshLayout, 1);
+    VertexBufferLayoutPushColor(&rContext.meshLayout, 1);
+
+    rContext.instanceLayout = VertexBufferLayoutInit();
+    VertexBufferLayoutPushFloat(&rContext.instanceLayout, 3);
+    VertexBufferLayoutPushFloat(&rContext.instanceLayout, 3);
+    VertexBufferLayoutPushFloat(&rContext.instanceLayout, 4);
+    VertexBufferLayoutPushColor(&rContext.instanceLayout, 1);
+    VertexBufferLayoutPushFloat(&rContext.instanceLayout, 1);
+
+    batch->instanceCapacity = RENDERER_BATCH_MAX_INSTANCES;
+    batch->instanceStream = StreamBufferInit(RENDERER_STREAM_BATCHES_PER_REGION * batch->instanceCapacity *
+                                             sizeof(InstanceData));
+
+    RenderQueueInit(&rContext.queue);
+    threadQueue = &rContext.queue;
+    isRenderThread = true;
+    renderState = RenderState{ 0, 0, BLEND_ALPHA, 1.0f };
+
+    rContext.instanceShader = ShaderLoadInstanced();
+    rContext.instancing = rContext.instanceShader.rendererID != 0;
+    rContext.sdfShader = ShaderLoadSDF();
+
+    Vertex quadVertices[] = {
+        { Vec2{ 0, 1 }, Vec2{ 0.0f, 1.0f }, WHITE },
+        { Vec2{ 1, 1 }, Vec2{ 1.0f, 1.0f }, WHITE },
+        { Vec2{ 0, 0 }, Vec2{ 0.0f, 0.0f }, WHITE },
+        { Vec2{ 1, 0 }, Vec2{ 1.0f, 0.0f }, WHITE }
+    };
+    rContext.quadMesh = MeshInit(TRIANGLE_STRIP, quadVertices, ARRAYCOUNT(quadVertices));
+
+    // NOTE: Untextured primitives sample this texture, so they can share the batch state with sprites
+    rContext.defaultTexture = TextureCreate(1, 1, WHITE);
+    SASSERT_MSG(rContext.defaultTexture, "Failed to create default texture");
+
+    FontStartup();
+    RenderQueuePublishFrameState();
 
     isInit = true;
 
@@ -116,7 +664,49 @@ void RendererShutdown()
 {
     SASSERT_MSG(isInit == true, "Renderer is already shutdown");
 
+    // NOTE: Draws still queued may sample font atlases, they're flushed before the fonts go away
+    RendererFlush();
+    FontShutdown();
+    TextureUnload(&rContext.defaultTexture);
+
+    GeometryCacheClear();
+    MeshDelete(&rContext.quadMesh);
+
+    RenderBatch* batch = &rContext.batch;
+    VertexArrayDelete(&batch->va);
+    StreamBufferDelete(&batch->vertexStream);
+    StreamBufferDelete(&batch->instanceStream);
+
+    RenderQueueDelete(&rContext.queue);
+    threadQueue = nullptr;
+
+    // NOTE: Commands submitted after the last frame are dropped, queues still held by workers are lost
+    {
+        std::lock_guard<std::mutex> lock(threadQueueMutex);
+        for (RenderQueue* queue = rContext.pendingQueues; queue != nullptr;) {
+            RenderQueue* next = queue->next;
+            RenderQueueDelete(queue);
+            SFree(queue);
+            queue = next;
+        }
+        for (RenderQueue* queue = rContext.freeQueues; queue != nullptr;) {
+            RenderQueue* next = queue->next;
+            RenderQueueDelete(queue);
+            SFree(queue);
+            queue = next;
+        }
+    }
+
     VertexBufferLayoutDelete(&rContext.layout);
+    VertexBufferLayoutDelete(&rContext.meshLayout);
+    VertexBufferLayoutDelete(&rContext.instanceLayout);
+
+    if (rContext.instanceShader.rendererID) {
+        ShaderUnload(&rContext.instanceShader);
+    }
+    if (rContext.sdfShader.rendererID) {
+        ShaderUnload(&rContext.sdfShader);
+    }
 
     if (defaultShader.rendererID != rContext.boundShader.rendererID) {
         ShaderUnload(&defaultShader);
@@ -130,153 +720,1068 @@ void RendererShutdown()
 
 void RendererCreateViewport(f32 width, f32 height)
 {
+    RendererFlush();
+
     rContext.projMatrix = MatrixOrthogonal(0.0f, width, height, 0.0f, 0.0f, 1.0f);
     rContext.viewMatrix = Matrix4Identity();
-    GLCall(glViewport(0, 0, width, height));
+    rContext.viewProjMatrix = rContext.projMatrix * rContext.viewMatrix;
+    GLStateSetViewport(0, 0, (i32) width, (i32) height);
+}
+
+/*
+    Moves the camera, draws recorded by worker threads are culled against the view that was set
+    at the last EndDrawing()
+*/
+void RendererSetViewMatrix(Mat4 viewMatrix)
+{
+    RendererFlush();
+
+    rContext.viewMatrix = viewMatrix;
+    rContext.viewProjMatrix = rContext.projMatrix * rContext.viewMatrix;
 }
 
 void RendererSetPolygonMode(u32 face, u32 mode)
 {
+    RendererFlush();
     GLCall(glPolygonMode(face, mode));
 }
 
-VertexBuffer VertexBufferInit(const void* data, u32 size)
+/*
+    Sorts the recorded commands by key and submits them in as few batches as possible.
+    It is invoked implicitly whenever the shader or render state changes and at EndDrawing(),
+    commands are only reordered between two flushes.
+*/
+void RendererFlush()
 {
-    VertexBuffer result = { };
-    GLCall(glGenBuffers(1, &result.rendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, result.rendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    SASSERT_MSG(isRenderThread, "RendererFlush() can only be called from the render thread");
+    SASSERT_MSG(!RenderQueueIsBaking(), "RendererFlush() can't be called while a BakedLayer is recording");
+
+    RenderQueue* queue = &rContext.queue;
+    if (queue->commandCount > 0) {
+        for (u32 i = 0; i < queue->commandCount; i++) {
+            queue->sortKeys[i] = queue->commands[i].key;
+            queue->sortIndices[i] = i;
+        }
 
-    return result;
+        RadixSort64(queue->sortKeys, queue->sortIndices, queue->sortKeys + queue->commandCapacity,
+                    queue->sortIndices + queue->commandCapacity, queue->commandCount);
+
+        for (u32 i = 0; i < queue->commandCount; i++) {
+            RenderQueueSubmitCommand(&queue->commands[queue->sortIndices[i]]);
+        }
+
+        rContext.frameStats.commands += queue->commandCount;
+        queue->commandCount = 0;
+        queue->vertexCount = 0;
+        queue->instanceCount = 0;
+    }
+
+    rContext.frameStats.submittedPrimitives += queue->submittedPrimitives;
+    rContext.frameStats.culledPrimitives += queue->culledPrimitives;
+    queue->submittedPrimitives = 0;
+    queue->culledPrimitives = 0;
+
+    BatchSubmit();
 }
 
-VertexBuffer VertexBufferInit(const Vertex* data, u32 count)
+/*
+    Maps the stream space the batch is written to, each batch gets a full batch capacity
+*/
+static void BatchMap()
 {
-    VertexBuffer result = { };
-    GLCall(glGenBuffers(1, &result.rendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, result.rendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, count * sizeof(Vertex), data, GL_STATIC_DRAW));
-
-    return result;
+    RenderBatch* batch = &rContext.batch;
+
+    if (batch->type == RENDER_COMMAND_INSTANCES) {
+        if (!batch->instances) {
+            u32 offset = 0;
+            batch->instances = (InstanceData*) StreamBufferMap(&batch->instanceStream,
+                                                               batch->instanceCapacity * sizeof(InstanceData),
+                                                               sizeof(InstanceData), &offset);
+            batch->firstInstance = offset / sizeof(InstanceData);
+        }
+    } else {
+        if (!batch->vertices) {
+            u32 offset = 0;
+            batch->vertices = (BatchVertex*) StreamBufferMap(&batch->vertexStream,
+                                                             batch->vertexCapacity * sizeof(BatchVertex),
+                                                             sizeof(BatchVertex), &offset);
+            batch->firstVertex = offset / sizeof(BatchVertex);
+        }
+    }
 }
 
-void VertexBufferDelete(VertexBuffer* vb)
+/*
+    Issues the pending batch with a single draw call
+*/
+static void BatchSubmit()
 {
-    SASSERT_MSG(vb, "VertexBuffer can't be null");
+    RenderBatch* batch = &rContext.batch;
 
-    GLCall(glDeleteBuffers(1, &vb->rendererID));
+    if (batch->vertices) {
+        StreamBufferUnmap(&batch->vertexStream, batch->vertexCount * sizeof(BatchVertex));
+        batch->vertices = nullptr;
+    }
+    if (batch->instances) {
+        StreamBufferUnmap(&batch->instanceStream, batch->instanceCount * sizeof(InstanceData));
+        batch->instances = nullptr;
+    }
 
-    SMemZero(vb, sizeof(VertexBuffer));
+    if (batch->vertexCount == 0 && batch->instanceCount == 0) {
+        return;
+    }
+
+    for (u32 slot = 0; slot < batch->textureCount; slot++) {
+        TextureBind(batch->textures[slot], (i32) slot);
+    }
+
+    RendererApplyBlendMode(batch->blendMode);
+
+    Mat4 mvp = rContext.projMatrix * rContext.viewMatrix;
+
+    // NOTE: Instanced, SDF and worker thread batches carry their own shader, the bound one is restored after the draw
+    GLStateUseProgram(batch->shader.rendererID);
+    RendererApplyDrawState(batch->shader, nullptr, mvp);
+
+    if (batch->vertexCount > 0) {
+        VertexArrayBind(batch->va);
+
+        if (batch->mode == LINES) {
+            GLCall(glLineWidth(batch->lineWidth));
+        }
+
+        GLCall(glDrawArrays(batch->mode, batch->firstVertex, batch->vertexCount));
+    } else {
+        // NOTE: Base instances need GL 4.2, the instance attributes are pointed at the batch range instead
+        VertexArraySetAttributes(batch->mesh->va, batch->instanceStream.vb, &rContext.instanceLayout,
+                                 RENDERER_INSTANCE_FIRST_ATTRIBUTE, 1, batch->firstInstance * sizeof(InstanceData));
+
+        GLCall(glDrawArraysInstanced(batch->mesh->mode, 0, batch->mesh->vertexCount, batch->instanceCount));
+    }
+
+    GLStateUseProgram(rContext.boundShader.rendererID);
+    rContext.frameStats.drawCalls++;
+
+    batch->vertexCount = 0;
+    batch->instanceCount = 0;
+    batch->textureCount = 0;
 }
 
-void VertexBufferBind(VertexBuffer vb)
+/*
+    Merges the draws submitted by worker threads, flushes the frame and publishes the frame statistics,
+    called by EndDrawing(). Glyphs requested during the frame are rasterized once the frame is submitted.
+    Worker threads may still hold glyph quads that missed the merge, the atlases only evict pages or grow
+    while no worker draws are left outside the frame.
+*/
+void RendererEndFrame()
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, vb.rendererID));
+    SASSERT_MSG(!RenderQueueIsBaking(), "EndDrawing() can't be called while a BakedLayer is recording");
+
+    RenderQueueMergePending();
+    RendererFlush();
+    FontUpdateGlyphCaches();
+    RenderQueuePublishFrameState();
+
+    StreamBufferAdvance(&rContext.batch.vertexStream);
+    StreamBufferAdvance(&rContext.batch.instanceStream);
+
+    rContext.lastFrameStats = rContext.frameStats;
+    SMemZero(&rContext.frameStats, sizeof(RendererStats));
 }
 
-void VertexBufferUnbind()
+RendererStats RendererGetStats()
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    return rContext.lastFrameStats;
 }
 
-IndexBuffer IndexBufferInit(const u32* data, u32 count)
+/*
+    Draws on a higher layer are always drawn on top, within a layer draws are ordered by depth.
+    Draws with the same layer and depth are drawn in the order they were recorded.
+*/
+void RendererSetLayer(u8 layer)
 {
-    IndexBuffer result = { };
-    result.count = count;
-
-    GLCall(glGenBuffers(1, &result.rendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result.rendererID));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(u32), data, GL_STATIC_DRAW));
+    renderState.layer = layer;
+}
 
-    return result;
+u8 RendererGetLayer()
+{
+    return renderState.layer;
 }
 
-void IndexBufferDelete(IndexBuffer* ib)
+/*
+    Draws with a higher depth are drawn later, passing the y position gives y-sorting.
+    Only the upper 24 bits of the float are kept in the sort key.
+*/
+void RendererSetDepth(f32 depth)
 {
-    SASSERT_MSG(ib, "IndexBuffer can't be null");
+    u32 bits = 0;
+    SMemCopy(&bits, &depth, sizeof(u32));
 
-    GLCall(glDeleteBuffers(1, &ib->rendererID));
+    // NOTE: Flips the bits so that the unsigned order of the floats matches their numeric order
+    bits = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    renderState.depth = bits >> 8;
+}
 
-    SMemZero(ib, sizeof(IndexBuffer));
+void RendererSetBlendMode(BlendMode blendMode)
+{
+    SASSERT_MSG(blendMode >= BLEND_ALPHA && blendMode <= BLEND_PREMULTIPLIED_ALPHA, "Blend mode not supported!");
+    renderState.blendMode = blendMode;
 }
 
-void IndexBufferBind(IndexBuffer ib)
+BlendMode RendererGetBlendMode()
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib.rendererID));
+    return renderState.blendMode;
 }
 
-void IndexBufferUnbind()
+void RendererSetLineWidth(f32 width)
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    renderState.lineWidth = width;
 }
 
-VertexArray VertexArrayInit()
+void RendererSetInstancing(bool8 enabled)
 {
-    VertexArray result = { };
-    GLCall(glGenVertexArrays(1, &result.rendererID));
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(isRenderThread, "RendererSetInstancing() can only be called from the render thread");
 
-    return result;
+    if (enabled && !rContext.instanceShader.rendererID) {
+        LOG_WARN("Instanced rendering is not available, the instanced shader failed to load");
+        return;
+    }
+
+    rContext.instancing = enabled;
 }
 
-void VertexArrayDelete(VertexArray* va)
+/*
+    Instances are drawn with the built-in instanced shader, so they can only replace draws
+    that would have used the default shader. Worker threads always record for the default shader.
+*/
+bool8 RendererIsInstancingActive()
 {
-    SASSERT_MSG(va, "VertexArray can't be null");
-
-    GLCall(glDeleteVertexArrays(1, &va->rendererID));
-    SMemZero(va, sizeof(VertexArray));
+    if (RenderQueueIsBaking()) {
+        return false;
+    }
+    if (!isRenderThread) {
+        return RenderQueueGetThreadQueue()->frameState.instancing;
+    }
+    return rContext.instancing && rContext.boundShader.rendererID == defaultShader.rendererID;
 }
 
-void VertexArrayAddBuffer(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout)
+bool8 RendererIsRenderThread()
 {
-    SASSERT_MSG(layout, "VertexBufferLayout can't be null");
+    return isRenderThread;
+}
 
-    VertexArrayBind(va);
-    VertexBufferBind(vb);
+/*
+    Hands the draws recorded on the calling worker thread to the render thread, they are merged
+    into the frame at the next EndDrawing(). Draws are sorted with the main thread draws by their
+    layer and depth, with the same layer and depth they are drawn after the main thread draws.
+    Worker threads have to submit before a texture or mesh they drew with is unloaded, which is
+    asserted in debug builds.
+*/
+void RendererSubmitThreadCommands()
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(!isRenderThread, "RendererSubmitThreadCommands() can only be called from worker threads");
 
-    u32 offset = 0;
-    i32 i = 0;
-    for (VertexBufferElement* element = layout->elementsBegin; element != nullptr; element = element->next) {
-        GLCall(glEnableVertexAttribArray(i));
-        GLCall(glVertexAttribPointer(i, element->count, element->type, element->normalized, layout->stride,
-                                     (const void*) (uintptr_t) offset));
+    if (!threadQueue) {
+        return;
+    }
 
-        offset += element->count * GLGetSizeofType(element->type);
-        i++;
+    // NOTE: Queues without commands are submitted too, they carry the culling statistics
+    std::lock_guard<std::mutex> lock(threadQueueMutex);
+    rContext.recordingQueueCount--;
+    if (rContext.pendingQueuesTail) {
+        rContext.pendingQueuesTail->next = threadQueue;
+    } else {
+        rContext.pendingQueues = threadQueue;
     }
+    rContext.pendingQueuesTail = threadQueue;
+    threadQueue = nullptr;
 }
 
-void VertexArrayBind(VertexArray va)
+// NOTE: Worker draws outside the flushed frame, submitted after the last merge or still being recorded
+bool8 RendererHasThreadCommands()
 {
-    GLCall(glBindVertexArray(va.rendererID));
+    std::lock_guard<std::mutex> lock(threadQueueMutex);
+    return rContext.pendingQueues != nullptr || rContext.recordingQueueCount > 0;
 }
 
-void VertexArrayUnbind()
+const Mesh* RendererGetQuadMesh()
 {
-    GLCall(glBindVertexArray(0));
+    SASSERT_MSG(isInit, "Renderer is not started");
+    return &rContext.quadMesh;
 }
 
-VertexBufferLayout VertexBufferLayoutInit()
+const Texture2D* RendererGetDefaultTexture()
 {
-    VertexBufferLayout result = { };
-    return result;
+    SASSERT_MSG(isInit, "Renderer is not started");
+    return rContext.defaultTexture;
 }
 
-void VertexBufferLayoutDelete(VertexBufferLayout* layout)
+u32 RendererGetTextureSlotCount()
 {
-    SASSERT_MSG(layout, "VertexBufferLayout can't be null");
-
-    VertexBufferElement* tmp = nullptr;
-    while (layout->elementsBegin) {
-        tmp = layout->elementsBegin;
-        layout->elementsBegin = layout->elementsBegin->next;
-        SFree(tmp);
-    }
-
-    layout->elementsBegin = nullptr;
-    layout->elementsEnd = nullptr;
+    SASSERT_MSG(isInit, "Renderer is not started");
+    return rContext.textureSlotCount;
 }
 
-void VertexBufferLayoutPushFloat(VertexBufferLayout* layout, u32 count)
+// NOTE: Draws already recorded sample the texture before it's updated
+void RendererFlushTexture(const Texture2D* texture)
+{
+    RendererFlushResource(texture, nullptr, false);
+}
+
+void RendererReleaseTexture(const Texture2D* texture)
+{
+    RendererFlushResource(texture, nullptr, true);
+}
+
+/*
+    Flushes the frame when a recorded draw uses the texture or mesh, submitted worker queues are merged first
+    so none of them is left holding it. Draws worker threads are still recording can't be flushed, releasing
+    a resource asserts that no worker thread is recording.
+*/
+static void RendererFlushResource(const Texture2D* texture, const Mesh* mesh, bool8 release)
+{
+    bool8 referenced = RenderQueueReferences(&rContext.queue, texture, mesh);
+    {
+        std::lock_guard<std::mutex> lock(threadQueueMutex);
+        SASSERT_MSG(!release || rContext.recordingQueueCount == 0,
+                    "Worker threads have to submit their draws before a texture or mesh is unloaded");
+        for (RenderQueue* queue = rContext.pendingQueues; queue && !referenced; queue = queue->next) {
+            referenced = RenderQueueReferences(queue, texture, mesh);
+        }
+    }
+
+    if (referenced) {
+        RenderQueueMergePending();
+        RendererFlush();
+    }
+}
+
+/*
+    Unit circle centered at (1, 1) with a radius of 1, drawn as a triangle fan.
+    Built on the first request for a point count and reused until RendererShutdown()
+*/
+const CachedGeometry* RendererGetCircleGeometry(u32 pointCount)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(pointCount > 0, "pointCount must be greater than 0");
+
+    std::lock_guard<std::mutex> lock(geometryCacheMutex);
+
+    u64 key = GeometryCacheKey(GEOMETRY_CIRCLE, pointCount, 0);
+    auto it = geometryCache.find(key);
+    if (it != geometryCache.end()) {
+        GeometryCacheBuildMesh(&it->second);
+        return &it->second;
+    }
+
+    CachedGeometry* geometry = GeometryCacheInsert(key, TRIANGLE_FAN, pointCount + 2);
+    Vertex* vertices = geometry->vertices;
+
+    vertices[0].position = Vec2{ 1.0f, 1.0f };
+
+    const f32 stepAngle = 2 * S_PI32 / (f32) pointCount;
+    for (u32 i = 0; i <= pointCount; i++) {
+        vertices[i + 1].position.x = 1.0f + Cos((f32) i * stepAngle);
+        vertices[i + 1].position.y = 1.0f + Sin((f32) i * stepAngle);
+    }
+
+    GeometryCacheBuildMesh(geometry);
+    return geometry;
+}
+
+/*
+    Unit ring centered at (1, 1) with an outer radius of 1, drawn as a triangle list.
+    innerRatio is quantized so animated radii don't grow the cache without bound
+*/
+const CachedGeometry* RendererGetRingGeometry(u32 quadCount, f32 innerRatio)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(quadCount > 0, "quadCount must be greater than 0");
+
+    std::lock_guard<std::mutex> lock(geometryCacheMutex);
+
+    u32 ratio = (u32) Round(Clamp(innerRatio, 0.0f, 1.0f) * RENDERER_RING_RATIO_STEPS);
+    u64 key = GeometryCacheKey(GEOMETRY_RING, quadCount, ratio);
+    auto it = geometryCache.find(key);
+    if (it != geometryCache.end()) {
+        GeometryCacheBuildMesh(&it->second);
+        return &it->second;
+    }
+
+    CachedGeometry* geometry = GeometryCacheInsert(key, TRIANGLES, 6 * quadCount);
+    Vertex* vertices = geometry->vertices;
+
+    const f32 innerRadius = (f32) ratio / RENDERER_RING_RATIO_STEPS;
+    const f32 stepAngle = 2 * S_PI32 / (f32) quadCount;
+
+    // NOTE: Neighbouring quads share an edge, so each angle is evaluated once
+    f32 sinStart = Sin(0.0f);
+    f32 cosStart = Cos(0.0f);
+    for (u32 quad = 0; quad < quadCount; quad++) {
+        f32 sinEnd = Sin((f32) (quad + 1) * stepAngle);
+        f32 cosEnd = Cos((f32) (quad + 1) * stepAngle);
+
+        Vec2 innerStart = { 1.0f + sinStart * innerRadius, 1.0f + cosStart * innerRadius };
+        Vec2 outerStart = { 1.0f + sinStart, 1.0f + cosStart };
+        Vec2 innerEnd = { 1.0f + sinEnd * innerRadius, 1.0f + cosEnd * innerRadius };
+        Vec2 outerEnd = { 1.0f + sinEnd, 1.0f + cosEnd };
+
+        Vertex* quadVertices = vertices + 6 * quad;
+        quadVertices[0].position = innerStart;
+        quadVertices[1].position = outerStart;
+        quadVertices[2].position = innerEnd;
+        quadVertices[3].position = innerEnd;
+        quadVertices[4].position = outerStart;
+        quadVertices[5].position = outerEnd;
+
+        sinStart = sinEnd;
+        cosStart = cosEnd;
+    }
+
+    GeometryCacheBuildMesh(geometry);
+    return geometry;
+}
+
+static u64 GeometryCacheKey(u32 type, u32 count, u32 ratio)
+{
+    return ((u64) type << 56) | ((u64) (count & 0xFFFFFF) << 32) | (u64) ratio;
+}
+
+static CachedGeometry* GeometryCacheInsert(u64 key, DrawMode mode, u32 vertexCount)
+{
+    CachedGeometry* geometry = &geometryCache[key];
+    geometry->mode = mode;
+    geometry->vertexCount = vertexCount;
+
+    u64 verticesSize = vertexCount * sizeof(Vertex);
+    geometry->vertices = (Vertex*) SMalloc(verticesSize, MEMORY_TAG_RENDERER);
+    SMemZero(geometry->vertices, verticesSize);
+    for (u32 i = 0; i < vertexCount; i++) {
+        geometry->vertices[i].color = WHITE;
+    }
+
+    return geometry;
+}
+
+/*
+    Meshes need the GL context, geometry first requested by a worker thread only gets its mesh
+    once the render thread asks for it. Worker threads never instance cached geometry.
+*/
+static void GeometryCacheBuildMesh(CachedGeometry* geometry)
+{
+    if (isRenderThread && !geometry->mesh.va.rendererID) {
+        geometry->mesh = MeshInit(geometry->mode, geometry->vertices, geometry->vertexCount);
+    }
+}
+
+static void GeometryCacheClear()
+{
+    for (auto& it : geometryCache) {
+        if (it.second.mesh.va.rendererID) {
+            MeshDelete(&it.second.mesh);
+        }
+        SFree(it.second.vertices);
+    }
+    geometryCache.clear();
+}
+
+Mesh MeshInit(DrawMode mode, const Vertex* vertices, u32 count)
+{
+    SASSERT_MSG(vertices, "vertices can't be null");
+    SASSERT_MSG(rContext.batch.instanceStream.vb.rendererID, "Renderer is not started");
+
+    Mesh result = { };
+    result.mode = mode;
+    result.vertexCount = count;
+    result.boundsMin = count > 0 ? vertices[0].position : Vector2Zero();
+    result.boundsMax = result.boundsMin;
+    for (u32 i = 1; i < count; i++) {
+        result.boundsMin = Vector2Min(result.boundsMin, vertices[i].position);
+        result.boundsMax = Vector2Max(result.boundsMax, vertices[i].position);
+    }
+    result.va = VertexArrayInit();
+    result.vb = VertexBufferInit(vertices, count);
+    VertexArrayAddBuffer(result.va, result.vb, &rContext.meshLayout);
+    VertexArrayAddInstanceBuffer(result.va, rContext.batch.instanceStream.vb, &rContext.instanceLayout,
+                                 RENDERER_INSTANCE_FIRST_ATTRIBUTE);
+
+    return result;
+}
+
+void MeshDelete(Mesh* mesh)
+{
+    SASSERT_MSG(mesh, "Mesh can't be null");
+
+    RendererFlushResource(nullptr, mesh, true);
+
+    if (rContext.batch.mesh == mesh) {
+        rContext.batch.mesh = nullptr;
+    }
+
+    VertexBufferDelete(&mesh->vb);
+    VertexArrayDelete(&mesh->va);
+
+    SMemZero(mesh, sizeof(Mesh));
+}
+
+BakedLayer* BakedLayerCreate()
+{
+    BakedLayer* layer = (BakedLayer*) SMalloc(sizeof(BakedLayer), MEMORY_TAG_RENDERER);
+    layer->dirty = true;
+
+    return layer;
+}
+
+void BakedLayerDelete(BakedLayer** layer)
+{
+    SASSERT_MSG(layer && *layer, "BakedLayer can't be null");
+    SASSERT_MSG(!(*layer)->recording, "BakedLayer is still recording");
+
+    if ((*layer)->vb.rendererID) {
+        VertexArrayDelete(&(*layer)->va);
+        VertexBufferDelete(&(*layer)->vb);
+    }
+    SFree((*layer)->groups);
+    SFree(*layer);
+
+    *layer = nullptr;
+}
+
+/*
+    Redirects the draws of the render thread into the layer until BakedLayerEnd(). Draws are recorded
+    in local space without culling or instancing, the textures and shaders they use must outlive the layer.
+    Nothing can be flushed while recording, uniforms are read when the layer is drawn so they can't be set.
+*/
+void BakedLayerBegin(BakedLayer* layer)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(layer, "BakedLayer can't be null");
+    SASSERT_MSG(isRenderThread, "BakedLayer can only be recorded on the render thread");
+    SASSERT_MSG(!RenderQueueIsBaking(), "Another BakedLayer is already recording");
+
+    RendererFlush();
+    RenderQueueInit(&layer->queue);
+    layer->recording = true;
+    threadQueue = &layer->queue;
+}
+
+/*
+    Sorts the recorded draws, merges them into as few groups as the texture slots allow and
+    uploads the vertices, the previous content of the layer is replaced
+*/
+void BakedLayerEnd(BakedLayer* layer)
+{
+    SASSERT_MSG(layer, "BakedLayer can't be null");
+    SASSERT_MSG(layer->recording, "BakedLayerBegin() must be called before BakedLayerEnd()");
+
+    threadQueue = &rContext.queue;
+    layer->recording = false;
+
+    RenderQueue* queue = &layer->queue;
+    for (u32 i = 0; i < queue->commandCount; i++) {
+        queue->sortKeys[i] = queue->commands[i].key;
+        queue->sortIndices[i] = i;
+    }
+    RadixSort64(queue->sortKeys, queue->sortIndices, queue->sortKeys + queue->commandCapacity,
+                queue->sortIndices + queue->commandCapacity, queue->commandCount);
+
+    SFree(layer->groups);
+    layer->groups = (BakedGroup*) SMalloc((queue->commandCount + 1) * sizeof(BakedGroup), MEMORY_TAG_RENDERER);
+    layer->groupCount = 0;
+    layer->vertexCount = 0;
+
+    BatchVertex* vertices = (BatchVertex*) SMalloc((queue->vertexCount + 1) * sizeof(BatchVertex),
+                                                   MEMORY_TAG_RENDERER);
+    BakedGroup* group = nullptr;
+    for (u32 i = 0; i < queue->commandCount; i++) {
+        const RenderCommand* command = &queue->commands[queue->sortIndices[i]];
+        SASSERT_MSG(command->type == RENDER_COMMAND_VERTICES, "BakedLayer can't record instances");
+
+        bool8 sameState = group && group->mode == command->mode && group->blendMode == command->blendMode &&
+                          group->shader.rendererID == command->shader.rendererID;
+        if (sameState && command->mode == LINES) {
+            sameState = !(group->lineWidth < command->lineWidth || group->lineWidth > command->lineWidth);
+        }
+
+        u32 slot = 0;
+        if (sameState) {
+            while (slot < group->textureCount && group->textures[slot] != command->texture) {
+                slot++;
+            }
+            sameState = slot < rContext.textureSlotCount;
+        }
+
+        if (!sameState) {
+            group = &layer->groups[layer->groupCount++];
+            group->textureCount = 0;
+            group->shader = command->shader;
+            group->mode = command->mode;
+            group->blendMode = command->blendMode;
+            group->lineWidth = command->lineWidth;
+            group->first = layer->vertexCount;
+            group->count = 0;
+            slot = 0;
+        }
+        if (slot == group->textureCount) {
+            group->textures[group->textureCount++] = command->texture;
+        }
+
+        BatchVertex* dst = vertices + layer->vertexCount;
+        SMemCopy(dst, queue->vertices + command->first, command->count * sizeof(BatchVertex));
+        for (u32 v = 0; v < command->count; v++) {
+            dst[v].texIndex = (f32) slot;
+        }
+
+        layer->vertexCount += command->count;
+        group->count += command->count;
+    }
+
+    if (layer->vb.rendererID) {
+        VertexArrayDelete(&layer->va);
+        VertexBufferDelete(&layer->vb);
+    }
+    if (layer->vertexCount > 0) {
+        layer->va = VertexArrayInit();
+        layer->vb = VertexBufferInit(vertices, layer->vertexCount * sizeof(BatchVertex));
+        VertexArrayAddBuffer(layer->va, layer->vb, &rContext.layout);
+    }
+
+    SFree(vertices);
+    RenderQueueDelete(queue);
+    layer->dirty = false;
+}
+
+void BakedLayerMarkDirty(BakedLayer* layer)
+{
+    SASSERT_MSG(layer, "BakedLayer can't be null");
+    layer->dirty = true;
+}
+
+bool8 BakedLayerIsDirty(const BakedLayer* layer)
+{
+    SASSERT_MSG(layer, "BakedLayer can't be null");
+    return layer->dirty;
+}
+
+/*
+    Draws the baked content with one draw call per group, a dirty layer keeps drawing its last content
+*/
+void BakedLayerDraw(const BakedLayer* layer, Mat4 transformMatrix)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(layer, "BakedLayer can't be null");
+    SASSERT_MSG(isRenderThread, "BakedLayer can only be drawn from the render thread");
+    SASSERT_MSG(!RenderQueueIsBaking(), "BakedLayer can't be drawn while a BakedLayer is recording");
+
+    if (layer->groupCount == 0) {
+        return;
+    }
+
+    RendererFlush();
+
+    VertexArrayBind(layer->va);
+    Mat4 mvp = rContext.viewProjMatrix * transformMatrix;
+
+    for (u32 i = 0; i < layer->groupCount; i++) {
+        const BakedGroup* group = &layer->groups[i];
+        GLStateUseProgram(group->shader.rendererID);
+        RendererApplyDrawState(group->shader, nullptr, mvp);
+
+        for (u32 slot = 0; slot < group->textureCount; slot++) {
+            TextureBind(group->textures[slot], (i32) slot);
+        }
+
+        RendererApplyBlendMode(group->blendMode);
+        if (group->mode == LINES) {
+            GLCall(glLineWidth(group->lineWidth));
+        }
+
+        GLCall(glDrawArrays(group->mode, group->first, group->count));
+        rContext.frameStats.drawCalls++;
+    }
+
+    GLStateUseProgram(rContext.boundShader.rendererID);
+}
+
+VertexBuffer VertexBufferInit(const void* data, u32 size)
+{
+    VertexBuffer result = { };
+    GLCall(glGenBuffers(1, &result.rendererID));
+    GLStateBindBuffer(GL_ARRAY_BUFFER, result.rendererID);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+
+    return result;
+}
+
+VertexBuffer VertexBufferInit(const Vertex* data, u32 count)
+{
+    VertexBuffer result = { };
+    GLCall(glGenBuffers(1, &result.rendererID));
+    GLStateBindBuffer(GL_ARRAY_BUFFER, result.rendererID);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, count * sizeof(Vertex), data, GL_STATIC_DRAW));
+
+    return result;
+}
+
+VertexBuffer VertexBufferInitDynamic(u32 size)
+{
+    VertexBuffer result = { };
+    GLCall(glGenBuffers(1, &result.rendererID));
+    GLStateBindBuffer(GL_ARRAY_BUFFER, result.rendererID);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+
+    return result;
+}
+
+void VertexBufferSetData(VertexBuffer vb, const void* data, u32 size, u32 offset)
+{
+    SASSERT_MSG(data, "data can't be null");
+
+    GLStateBindBuffer(GL_ARRAY_BUFFER, vb.rendererID);
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
+void VertexBufferDelete(VertexBuffer* vb)
+{
+    SASSERT_MSG(vb, "VertexBuffer can't be null");
+
+    GLStateInvalidateBuffer(vb->rendererID);
+    GLCall(glDeleteBuffers(1, &vb->rendererID));
+
+    SMemZero(vb, sizeof(VertexBuffer));
+}
+
+void VertexBufferBind(VertexBuffer vb)
+{
+    GLStateBindBuffer(GL_ARRAY_BUFFER, vb.rendererID);
+}
+
+void VertexBufferUnbind()
+{
+    GLStateBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+    Streams CPU written data to the GPU through a ring of regions. With GL 4.4 or ARB_buffer_storage
+    the buffer is mapped once persistently and coherently, each region is guarded by a fence that is
+    waited on before the region is written again. Otherwise ranges are mapped unsynchronized and the
+    buffer is orphaned when the ring wraps, which lets the driver keep the old storage alive.
+*/
+StreamBuffer StreamBufferInit(u32 regionSize)
+{
+    SASSERT_MSG(regionSize > 0, "regionSize must be greater than 0");
+
+    StreamBuffer result = { };
+    result.regionSize = regionSize;
+    result.size = regionSize * STREAM_BUFFER_REGION_COUNT;
+    result.persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+    GLCall(glGenBuffers(1, &result.vb.rendererID));
+    GLStateBindBuffer(GL_ARRAY_BUFFER, result.vb.rendererID);
+
+    if (result.persistent) {
+        u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_ARRAY_BUFFER, result.size, nullptr, flags));
+        GLCall(result.mapped = (u8*) glMapBufferRange(GL_ARRAY_BUFFER, 0, result.size, flags));
+
+        if (!result.mapped) {
+            LOG_WARN("StreamBuffer(ID:%d): Persistent mapping failed, falling back to orphaning", result.vb.rendererID);
+            GLStateInvalidateBuffer(result.vb.rendererID);
+            GLCall(glDeleteBuffers(1, &result.vb.rendererID));
+            GLCall(glGenBuffers(1, &result.vb.rendererID));
+            GLStateBindBuffer(GL_ARRAY_BUFFER, result.vb.rendererID);
+            result.persistent = false;
+        }
+    }
+
+    if (!result.persistent) {
+        GLCall(glBufferData(GL_ARRAY_BUFFER, result.size, nullptr, GL_STREAM_DRAW));
+    }
+
+    LOG_TRACE("StreamBuffer(ID:%d): %u bytes, %s", result.vb.rendererID, result.size,
+              result.persistent ? "persistently mapped" : "orphaned");
+
+    return result;
+}
+
+void StreamBufferDelete(StreamBuffer* stream)
+{
+    SASSERT_MSG(stream, "StreamBuffer can't be null");
+
+    for (u32 region = 0; region < STREAM_BUFFER_REGION_COUNT; region++) {
+        GPUFenceDelete(&stream->fences[region]);
+    }
+
+    if (stream->mapped) {
+        GLStateBindBuffer(GL_ARRAY_BUFFER, stream->vb.rendererID);
+        GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+
+    VertexBufferDelete(&stream->vb);
+    SMemZero(stream, sizeof(StreamBuffer));
+}
+
+/*
+    Returns size writable bytes at an offset aligned to alignment, *outOffset receives the offset
+    in the buffer. The pointer stays valid until StreamBufferUnmap().
+*/
+void* StreamBufferMap(StreamBuffer* stream, u32 size, u32 alignment, u32* outOffset)
+{
+    SASSERT_MSG(stream, "StreamBuffer can't be null");
+    SASSERT_MSG(size <= stream->regionSize, "size doesn't fit in a StreamBuffer region");
+    SASSERT_MSG(alignment > 0, "alignment must be greater than 0");
+
+    u32 head = ((stream->head + alignment - 1) / alignment) * alignment;
+
+    if (stream->persistent) {
+        u32 regionEnd = (stream->region + 1) * stream->regionSize;
+        if (head + size > regionEnd) {
+            StreamBufferAdvance(stream);
+            head = stream->head;
+        }
+    } else if (head + size > stream->size) {
+        GLStateBindBuffer(GL_ARRAY_BUFFER, stream->vb.rendererID);
+        GLCall(glBufferData(GL_ARRAY_BUFFER, stream->size, nullptr, GL_STREAM_DRAW));
+        head = 0;
+    }
+
+    stream->head = head;
+    *outOffset = head;
+
+    if (stream->persistent) {
+        return stream->mapped + head;
+    }
+
+    u32 flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+    GLStateBindBuffer(GL_ARRAY_BUFFER, stream->vb.rendererID);
+    GLCall(void* data = glMapBufferRange(GL_ARRAY_BUFFER, head, size, flags));
+    SASSERT_MSG(data, "Failed to map StreamBuffer range");
+
+    return data;
+}
+
+/*
+    Commits the first usedSize bytes written since StreamBufferMap()
+*/
+void StreamBufferUnmap(StreamBuffer* stream, u32 usedSize)
+{
+    SASSERT_MSG(stream, "StreamBuffer can't be null");
+
+    if (!stream->persistent) {
+        GLStateBindBuffer(GL_ARRAY_BUFFER, stream->vb.rendererID);
+        GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+
+    stream->head += usedSize;
+}
+
+/*
+    Fences the region written so far and moves to the next one, waiting for the GPU to be done with it.
+    Called once per frame so that a frame never writes a region the previous frames still read.
+*/
+void StreamBufferAdvance(StreamBuffer* stream)
+{
+    SASSERT_MSG(stream, "StreamBuffer can't be null");
+
+    if (!stream->persistent) {
+        return;
+    }
+
+    u32 regionStart = stream->region * stream->regionSize;
+    if (stream->head == regionStart) {
+        return;
+    }
+
+    GPUFenceDelete(&stream->fences[stream->region]);
+    stream->fences[stream->region] = GPUFenceCreate();
+
+    stream->region = (stream->region + 1) % STREAM_BUFFER_REGION_COUNT;
+    stream->head = stream->region * stream->regionSize;
+
+    GPUFence* fence = &stream->fences[stream->region];
+    if (fence->sync && !GPUFenceIsSignaled(*fence)) {
+        rContext.frameStats.streamWaits++;
+        GPUFenceWait(*fence);
+    }
+    GPUFenceDelete(fence);
+}
+
+GPUFence GPUFenceCreate()
+{
+    GPUFence result = { };
+    GLCall(result.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    return result;
+}
+
+void GPUFenceDelete(GPUFence* fence)
+{
+    SASSERT_MSG(fence, "GPUFence can't be null");
+
+    if (fence->sync) {
+        GLCall(glDeleteSync(fence->sync));
+        fence->sync = nullptr;
+    }
+}
+
+bool8 GPUFenceIsSignaled(GPUFence fence)
+{
+    if (!fence.sync) {
+        return true;
+    }
+
+    GLCall(u32 result = glClientWaitSync(fence.sync, 0, 0));
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+/*
+    Blocks until the GPU has executed every command issued before the fence
+*/
+void GPUFenceWait(GPUFence fence)
+{
+    if (!fence.sync) {
+        return;
+    }
+
+    // NOTE: The first wait flushes the command stream, otherwise the fence might never be signaled
+    u32 flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        GLCall(u32 result = glClientWaitSync(fence.sync, flags, STREAM_BUFFER_WAIT_TIMEOUT));
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            return;
+        }
+        if (result == GL_WAIT_FAILED) {
+            LOG_ERROR("GPUFence: Wait failed");
+            return;
+        }
+        flags = 0;
+    }
+}
+
+IndexBuffer IndexBufferInit(const u32* data, u32 count)
+{
+    IndexBuffer result = { };
+    result.count = count;
+
+    GLCall(glGenBuffers(1, &result.rendererID));
+    GLStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result.rendererID);
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(u32), data, GL_STATIC_DRAW));
+
+    return result;
+}
+
+void IndexBufferDelete(IndexBuffer* ib)
+{
+    SASSERT_MSG(ib, "IndexBuffer can't be null");
+
+    GLStateInvalidateBuffer(ib->rendererID);
+    GLCall(glDeleteBuffers(1, &ib->rendererID));
+
+    SMemZero(ib, sizeof(IndexBuffer));
+}
+
+void IndexBufferBind(IndexBuffer ib)
+{
+    GLStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib.rendererID);
+}
+
+void IndexBufferUnbind()
+{
+    GLStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+VertexArray VertexArrayInit()
+{
+    VertexArray result = { };
+    GLCall(glGenVertexArrays(1, &result.rendererID));
+
+    return result;
+}
+
+void VertexArrayDelete(VertexArray* va)
+{
+    SASSERT_MSG(va, "VertexArray can't be null");
+
+    GLStateInvalidateVertexArray(va->rendererID);
+    GLCall(glDeleteVertexArrays(1, &va->rendererID));
+    SMemZero(va, sizeof(VertexArray));
+}
+
+void VertexArrayAddBuffer(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout)
+{
+    SASSERT_MSG(layout, "VertexBufferLayout can't be null");
+
+    VertexArraySetAttributes(va, vb, layout, 0, 0, 0);
+}
+
+/*
+    Attributes of an instance buffer advance once per instance, they start at firstAttribute
+    so they don't overlap the per vertex attributes of the same vertex array
+*/
+void VertexArrayAddInstanceBuffer(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout,
+                                  u32 firstAttribute)
+{
+    SASSERT_MSG(layout, "VertexBufferLayout can't be null");
+
+    VertexArraySetAttributes(va, vb, layout, firstAttribute, 1, 0);
+}
+
+/*
+    Points the layout attributes at vb starting at offset bytes, a divisor of 0 advances them per vertex
+*/
+static void VertexArraySetAttributes(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout,
+                                     u32 firstAttribute, u32 divisor, u32 offset)
+{
+    VertexArrayBind(va);
+    VertexBufferBind(vb);
+
+    u32 i = firstAttribute;
+    for (VertexBufferElement* element = layout->elementsBegin; element != nullptr; element = element->next) {
+        GLCall(glEnableVertexAttribArray(i));
+        GLCall(glVertexAttribPointer(i, element->count, element->type, element->normalized, layout->stride,
+                                     (const void*) (uintptr_t) offset));
+        if (divisor > 0) {
+            GLCall(glVertexAttribDivisor(i, divisor));
+        }
+
+        offset += element->count * GLGetSizeofType(element->type);
+        i++;
+    }
+}
+
+void VertexArrayBind(VertexArray va)
+{
+    GLStateBindVertexArray(va.rendererID);
+}
+
+void VertexArrayUnbind()
+{
+    GLStateBindVertexArray(0);
+}
+
+VertexBufferLayout VertexBufferLayoutInit()
+{
+    VertexBufferLayout result = { };
+    return result;
+}
+
+void VertexBufferLayoutDelete(VertexBufferLayout* layout)
+{
+    SASSERT_MSG(layout, "VertexBufferLayout can't be null");
+
+    VertexBufferElement* tmp = nullptr;
+    while (layout->elementsBegin) {
+        tmp = layout->elementsBegin;
+        layout->elementsBegin = layout->elementsBegin->next;
+        SFree(tmp);
+    }
+
+    layout->elementsBegin = nullptr;
+    layout->elementsEnd = nullptr;
+}
+
+void VertexBufferLayoutPushFloat(VertexBufferLayout* layout, u32 count)
 {
     SASSERT(layout);
 
@@ -352,6 +1857,26 @@ void VertexBufferLayoutPushVec2(VertexBufferLayout* layout, u32 count)
     layout->stride += 2 * count * GLGetSizeofType(GL_FLOAT);
 }
 
+void VertexBufferLayoutPushColor(VertexBufferLayout* layout, u32 count)
+{
+    SASSERT(layout);
+
+    // NOTE: Packed RGBA8, normalized to [0, 1] by the vertex fetch
+    VertexBufferElement* element = (VertexBufferElement*) SMalloc(sizeof(VertexBufferElement), MEMORY_TAG_RENDERER);
+    element->type = GL_UNSIGNED_BYTE;
+    element->count = 4 * count;
+    element->normalized = GL_TRUE;
+
+    if (layout->elementsEnd) {
+        layout->elementsEnd->next = element;
+    } else {
+        layout->elementsBegin = element;
+    }
+
+    layout->elementsEnd = element;
+    layout->stride += 4 * count * GLGetSizeofType(GL_UNSIGNED_BYTE);
+}
+
 Shader ShaderLoadFromFiles(const char* vsFilePath, const char* fsFilePath)
 {
     SASSERT(vsFilePath && fsFilePath);
@@ -386,6 +1911,9 @@ Shader ShaderLoadFromMemory(const char* vsShader, const char* fsShader)
 {
     Shader result = { };
     result.rendererID = ShaderCreate(vsShader, fsShader);
+    if (result.rendererID) {
+        ShaderReflectUniforms(&result);
+    }
 
     LOG_DEBUG("Shader(ID:%d): Loaded successfully", result.rendererID);
 
@@ -394,39 +1922,121 @@ Shader ShaderLoadFromMemory(const char* vsShader, const char* fsShader)
 
 Shader ShaderLoadDefault()
 {
-    const char* vertexShader = R"(
-        #version 330 core
+    return ShaderLoadBatched(batchVertexShader, "outColor = texColor * ourColor;");
+}
 
-        layout(location = 0) in vec2 aPosition;
-        layout(location = 1) in vec2 aTexCord;
+/*
+    Antialiases the edge over the screen space derivative of the distance, so it stays sharp at every scale
+*/
+static Shader ShaderLoadSDF()
+{
+    const char* fragmentOutput = R"(
+            float distance = texColor.a;
+            float width = max(fwidth(distance), 0.0001f);
+            float alpha = smoothstep(0.5f - width, 0.5f + width, distance);
+            outColor = vec4(ourColor.rgb, ourColor.a * alpha);)";
 
-        out vec2 ourTexCord;
+    return ShaderLoadBatched(batchVertexShader, fragmentOutput);
+}
 
-        uniform mat4 uMvp;
+/*
+    Links a vertex shader producing ourTexCord, ourColor and ourTexIndex with the fragment shader
+    that samples the batch texture slots, fragmentOutput writes outColor from texColor and ourColor
+*/
+static Shader ShaderLoadBatched(const char* vertexShader, const char* fragmentOutput)
+{
+    // NOTE: GLSL 3.30 only indexes sampler arrays with constant expressions, a case is generated per slot
+    i32 maxTextureUnits = 0;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits));
+    i32 slotCount = Clamp(maxTextureUnits, 1, RENDERER_MAX_TEXTURE_SLOTS);
+
+    const u32 fragmentShaderLen = 8000;
+    char* fragmentShader = (char*) SAlloca(fragmentShaderLen);
+    i32 offset = snprintf(fragmentShader, fragmentShaderLen, R"(
+        #version 330 core
+
+        out vec4 outColor;
+        in vec2 ourTexCord;
+        in vec4 ourColor;
+        flat in int ourTexIndex;
+
+        uniform sampler2D uTextures[%d];
 
         void main()
         {
-            gl_Position = uMvp * vec4(aPosition, 0.0f, 1.0f);
-            ourTexCord = aTexCord;
+            vec4 texColor = vec4(1.0f);
+            switch (ourTexIndex) {
+)", slotCount);
+
+    for (i32 slot = 0; slot < slotCount; slot++) {
+        offset += snprintf(fragmentShader + offset, fragmentShaderLen - offset,
+                           "                case %d: texColor = texture(uTextures[%d], ourTexCord); break;\n",
+                           slot, slot);
+    }
+
+    snprintf(fragmentShader + offset, fragmentShaderLen - offset, R"(
+            }
+            %s
         }
-    )";
+    )", fragmentOutput);
+
+    Shader shader = ShaderLoadFromMemory(vertexShader, fragmentShader);
+
+    // NOTE: Missing uniforms are reported once here instead of on every draw
+    const char* requiredUniforms[] = { "uMvp", "uTextures" };
+    for (u32 i = 0; i < ARRAYCOUNT(requiredUniforms); i++) {
+        if (!ShaderHasUniform(shader, ShaderGetUniformID(requiredUniforms[i]))) {
+            LOG_ERROR("Shader(ID:%d): Built-in shader is missing '%s' uniform",
+                      shader.rendererID, requiredUniforms[i]);
+        }
+    }
+
+    i32* samplers = (i32*) SAlloca(slotCount * sizeof(i32));
+    for (i32 slot = 0; slot < slotCount; slot++) {
+        samplers[slot] = slot;
+    }
 
-    const char* fragmentShader = R"(
+    i32 samplersLocation = ShaderGetUniformLocation(shader, UNIFORM_ID("uTextures"));
+    if (samplersLocation != -1) {
+        GLStateUseProgram(shader.rendererID);
+        GLCall(glUniform1iv(samplersLocation, slotCount, samplers));
+        GLStateUseProgram(rContext.boundShader.rendererID);
+    }
+
+    return shader;
+}
+
+static Shader ShaderLoadInstanced()
+{
+    const char* vertexShader = R"(
         #version 330 core
 
-        out vec4 outColor;
-        in vec2 ourTexCord;
+        layout(location = 0) in vec2 aPosition;
+        layout(location = 1) in vec2 aTexCord;
+        layout(location = 4) in vec3 aTransformRow0;
+        layout(location = 5) in vec3 aTransformRow1;
+        layout(location = 6) in vec4 aTexRect;
+        layout(location = 7) in vec4 aColor;
+        layout(location = 8) in float aTexIndex;
+
+        out vec2 ourTexCord;
+        out vec4 ourColor;
+        flat out int ourTexIndex;
 
-        uniform vec4 uColor;
-        uniform sampler2D uTexture0;
+        uniform mat4 uMvp;
 
         void main()
         {
-            outColor = texture(uTexture0, ourTexCord) * uColor;
+            vec3 localPosition = vec3(aPosition, 1.0f);
+            vec2 position = vec2(dot(aTransformRow0, localPosition), dot(aTransformRow1, localPosition));
+            gl_Position = uMvp * vec4(position, 0.0f, 1.0f);
+            ourTexCord = mix(aTexRect.xy, aTexRect.zw, aTexCord);
+            ourColor = aColor;
+            ourTexIndex = int(aTexIndex + 0.5f);
         }
     )";
 
-    return ShaderLoadFromMemory(vertexShader, fragmentShader);
+    return ShaderLoadBatched(vertexShader, "outColor = texColor * ourColor;");
 }
 
 void ShaderUnload(Shader* shader)
@@ -435,31 +2045,63 @@ void ShaderUnload(Shader* shader)
 
     SFree(shader->vsFilePath);
     SFree(shader->fsFilePath);
+    SFree(shader->uniforms);
+    GLStateInvalidateProgram(shader->rendererID);
     GLCall(glDeleteProgram(shader->rendererID));
 
-    LOG_TRACE("Shader(ID:%d): Deleted successfully", shader->rendererID);
-    SMemZero(shader, sizeof(Shader));
+    LOG_TRACE("Shader(ID:%d): Deleted successfully", shader->rendererID);
+    SMemZero(shader, sizeof(Shader));
+}
+
+UniformID ShaderGetUniformID(const char* uniformName)
+{
+    SASSERT_MSG(uniformName, "uniformName can't be null");
+
+    UniformID result = { StringHash(uniformName) };
+    return result;
+}
+
+bool8 ShaderHasUniform(Shader shader, UniformID uniform)
+{
+    return ShaderGetUniformLocation(shader, uniform) != -1;
 }
 
-static i32 ShaderGetUniformLocation(Shader shader, const char* uniformName)
+/*
+    O(1) lookup in the uniform table filled at link time, no driver calls or string compares
+*/
+i32 ShaderGetUniformLocation(Shader shader, UniformID uniform)
 {
-    GLCall(i32 location = glGetUniformLocation(shader.rendererID, uniformName));
-    if (location == -1) {
-        LOG_WARN("Failed to find '%s' uniform location", uniformName);
+    if (!shader.uniforms) {
+        return -1;
     }
 
-    return location;
+    u32 mask = shader.uniformCapacity - 1;
+    for (u32 i = uniform.hash & mask;; i = (i + 1) & mask) {
+        const ShaderUniform* entry = &shader.uniforms[i];
+        if (entry->location == -1) {
+            return -1;
+        }
+        if (entry->hash == uniform.hash) {
+            return entry->location;
+        }
+    }
 }
 
+// NOTE: Commands keep a copy of the shader, baked layers record shader changes without a flush
 void ShaderBind(Shader shader)
 {
-    GLCall(glUseProgram(shader.rendererID));
+    if (rContext.boundShader.rendererID != shader.rendererID && !RenderQueueIsBaking()) {
+        RendererFlush();
+    }
+
+    GLStateUseProgram(shader.rendererID);
     rContext.boundShader = shader;
 }
 
 void ShaderUnbind()
 {
-    GLCall(glUseProgram(0));
+    RendererFlush();
+    GLStateUseProgram(0);
 }
 
 Shader* ShaderGetBound()
@@ -498,6 +2140,86 @@ static u32 ShaderCreate(const char* vertexShader, const char* fragmentShader)
     return program;
 }
 
+static void ShaderReflectUniforms(Shader* shader)
+{
+    i32 uniformCount = 0;
+    i32 maxNameLength = 0;
+    GLCall(glGetProgramiv(shader->rendererID, GL_ACTIVE_UNIFORMS, &uniformCount));
+    GLCall(glGetProgramiv(shader->rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+
+    // NOTE: Array elements get an entry each, counted here to size the table
+    u32 entryCount = 0;
+    for (i32 i = 0; i < uniformCount; i++) {
+        i32 size = 0;
+        u32 type = 0;
+        GLCall(glGetActiveUniform(shader->rendererID, i, 0, nullptr, &size, &type, nullptr));
+        entryCount += (size > 1) ? size + 1 : 1;
+    }
+
+    // NOTE: Keep the load factor under 0.5 so probing stays short
+    shader->uniformCapacity = 8;
+    while (shader->uniformCapacity < entryCount * 2) {
+        shader->uniformCapacity <<= 1;
+    }
+
+    u32 tableSize = shader->uniformCapacity * sizeof(ShaderUniform);
+    shader->uniforms = (ShaderUniform*) SMalloc(tableSize, MEMORY_TAG_RENDERER);
+    for (u32 i = 0; i < shader->uniformCapacity; i++) {
+        shader->uniforms[i].location = -1;
+    }
+
+    u32 nameLength = maxNameLength + 16;
+    char* name = (char*) SAlloca(nameLength);
+    for (i32 i = 0; i < uniformCount; i++) {
+        i32 size = 0;
+        u32 type = 0;
+        GLCall(glGetActiveUniform(shader->rendererID, i, maxNameLength, nullptr, &size, &type, name));
+
+        // NOTE: Arrays are reported as 'name[0]', register the base name and every element
+        char* subscript = strchr(name, '[');
+        if (subscript) {
+            *subscript = '\0';
+        }
+
+        GLCall(i32 location = glGetUniformLocation(shader->rendererID, name));
+        ShaderInsertUniform(shader, name, location);
+
+        if (size > 1) {
+            u32 baseLength = strlen(name);
+            for (i32 element = 0; element < size; element++) {
+                snprintf(name + baseLength, nameLength - baseLength, "[%d]", element);
+                GLCall(location = glGetUniformLocation(shader->rendererID, name));
+                ShaderInsertUniform(shader, name, location);
+            }
+        }
+    }
+
+    LOG_TRACE("Shader(ID:%d): %d active uniforms reflected", shader->rendererID, uniformCount);
+}
+
+static void ShaderInsertUniform(Shader* shader, const char* uniformName, i32 location)
+{
+    if (location == -1) {
+        return;
+    }
+
+    u32 hash = StringHash(uniformName);
+    u32 mask = shader->uniformCapacity - 1;
+    for (u32 i = hash & mask;; i = (i + 1) & mask) {
+        ShaderUniform* entry = &shader->uniforms[i];
+        if (entry->location == -1) {
+            entry->hash = hash;
+            entry->location = location;
+            return;
+        }
+        if (entry->hash == hash) {
+            LOG_ERROR("Shader(ID:%d): '%s' uniform hash collides with another uniform",
+                      shader->rendererID, uniformName);
+            return;
+        }
+    }
+}
+
 static u32 ShaderCompile(u32 type, const char* source)
 {
     GLCall(u32 id = glCreateShader(type));
@@ -525,98 +2247,164 @@ static u32 ShaderCompile(u32 type, const char* source)
 
 void ShaderSetUniform1f(Shader shader, const char* uniformName, f32 v)
 {
+    ShaderSetUniform1f(shader, ShaderGetUniformID(uniformName), v);
+}
+
+void ShaderSetUniform2f(Shader shader, const char* uniformName, f32 v0, f32 v1)
+{
+    ShaderSetUniform2f(shader, ShaderGetUniformID(uniformName), v0, v1);
+}
+
+void ShaderSetUniformVec2(Shader shader, const char* uniformName, Vec2 v)
+{
+    ShaderSetUniformVec2(shader, ShaderGetUniformID(uniformName), v);
+}
+
+void ShaderSetUniform3f(Shader shader, const char* uniformName, f32 v0, f32 v1, f32 v2)
+{
+    ShaderSetUniform3f(shader, ShaderGetUniformID(uniformName), v0, v1, v2);
+}
+
+void ShaderSetUniformVec3(Shader shader, const char* uniformName, Vec3 v)
+{
+    ShaderSetUniformVec3(shader, ShaderGetUniformID(uniformName), v);
+}
+
+void ShaderSetUniform4f(Shader shader, const char* uniformName, f32 v0, f32 v1, f32 v2, f32 v3)
+{
+    ShaderSetUniform4f(shader, ShaderGetUniformID(uniformName), v0, v1, v2, v3);
+}
+
+void ShaderSetUniformVec4(Shader shader, const char* uniformName, Vec4 v)
+{
+    ShaderSetUniformVec4(shader, ShaderGetUniformID(uniformName), v);
+}
+
+void ShaderSetUniform1i(Shader shader, const char* uniformName, i32 v)
+{
+    ShaderSetUniform1i(shader, ShaderGetUniformID(uniformName), v);
+}
+
+void ShaderSetMatrix2(Shader shader, const char* uniformName, Mat2 mat)
+{
+    ShaderSetMatrix2(shader, ShaderGetUniformID(uniformName), mat);
+}
+
+void ShaderSetMatrix3(Shader shader, const char* uniformName, Mat3 mat)
+{
+    ShaderSetMatrix3(shader, ShaderGetUniformID(uniformName), mat);
+}
+
+void ShaderSetMatrix4(Shader shader, const char* uniformName, Mat4 mat)
+{
+    ShaderSetMatrix4(shader, ShaderGetUniformID(uniformName), mat);
+}
+
+void ShaderSetUniform1f(Shader shader, UniformID uniform, f32 v)
+{
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform1f(location, v));
     }
 }
 
-void ShaderSetUniform2f(Shader shader, const char* uniformName, f32 v0, f32 v1)
+void ShaderSetUniform2f(Shader shader, UniformID uniform, f32 v0, f32 v1)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform2f(location, v0, v1));
     }
 }
 
-void ShaderSetUniformVec2(Shader shader, const char* uniformName, Vec2 v)
+void ShaderSetUniformVec2(Shader shader, UniformID uniform, Vec2 v)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform2fv(location, 1, v.f));
     }
 }
 
-void ShaderSetUniform3f(Shader shader, const char* uniformName, f32 v0, f32 v1, f32 v2)
+void ShaderSetUniform3f(Shader shader, UniformID uniform, f32 v0, f32 v1, f32 v2)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform3f(location, v0, v1, v2));
     }
 }
 
-void ShaderSetUniformVec3(Shader shader, const char* uniformName, Vec3 v)
+void ShaderSetUniformVec3(Shader shader, UniformID uniform, Vec3 v)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform3fv(location, 1, v.f));
     }
 }
 
-void ShaderSetUniform4f(Shader shader, const char* uniformName, f32 v0, f32 v1, f32 v2, f32 v3)
+void ShaderSetUniform4f(Shader shader, UniformID uniform, f32 v0, f32 v1, f32 v2, f32 v3)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform4f(location, v0, v1, v2, v3));
     }
 }
 
-void ShaderSetUniformVec4(Shader shader, const char* uniformName, Vec4 v)
+void ShaderSetUniformVec4(Shader shader, UniformID uniform, Vec4 v)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform4fv(location, 1, (const f32*) v.f));
     }
 }
 
-void ShaderSetUniform1i(Shader shader, const char* uniformName, i32 v)
+void ShaderSetUniform1i(Shader shader, UniformID uniform, i32 v)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniform1i(location, v));
     }
 }
 
-void ShaderSetMatrix2(Shader shader, const char* uniformName, Mat2 mat)
+void ShaderSetMatrix2(Shader shader, UniformID uniform, Mat2 mat)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniformMatrix4fv(location, 1, GL_TRUE, (f32*) mat.f));
     }
 }
 
-void ShaderSetMatrix3(Shader shader, const char* uniformName, Mat3 mat)
+void ShaderSetMatrix3(Shader shader, UniformID uniform, Mat3 mat)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniformMatrix4fv(location, 1, GL_TRUE, (f32*) mat.f));
     }
 }
 
-void ShaderSetMatrix4(Shader shader, const char* uniformName, Mat4 mat)
+void ShaderSetMatrix4(Shader shader, UniformID uniform, Mat4 mat)
 {
+    RendererFlush();
     ShaderBind(shader);
-    i32 location = ShaderGetUniformLocation(shader, uniformName);
+    i32 location = ShaderGetUniformLocation(shader, uniform);
     if (location != -1) {
         GLCall(glUniformMatrix4fv(location, 1, GL_TRUE, (f32*) mat.f));
     }
@@ -625,44 +2413,622 @@ void ShaderSetMatrix4(Shader shader, const char* uniformName, Mat4 mat)
 void RendererDraw(DrawMode mode, VertexArray va, IndexBuffer ib, const Texture2D* texture, Mat4 transformMatrix)
 {
     SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(isRenderThread, "Vertex arrays can only be drawn from the render thread");
     SASSERT_MSG(texture, "texture can't be null");
 
-    TextureBind(texture, 0);
+    RendererFlush();
+    RendererApplyBlendMode(renderState.blendMode);
+
     VertexArrayBind(va);
     IndexBufferBind(ib);
 
     Mat4 mvp = rContext.projMatrix * rContext.viewMatrix * transformMatrix;
-    ShaderSetMatrix4(rContext.boundShader, "uMvp", mvp);
+    RendererApplyDrawState(rContext.boundShader, texture, mvp);
 
     GLCall(glDrawElements(mode, ib.count, GL_UNSIGNED_INT, nullptr));
+    rContext.frameStats.drawCalls++;
 }
 
 void RendererDraw(DrawMode mode, VertexArray va, u32 count, const Texture2D* texture, Mat4 transformMatrix)
 {
     SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(isRenderThread, "Vertex arrays can only be drawn from the render thread");
     SASSERT_MSG(texture, "texture can't be null");
 
-    TextureBind(texture, 0);
+    RendererFlush();
+    RendererApplyBlendMode(renderState.blendMode);
+
     VertexArrayBind(va);
 
     Mat4 mvp = rContext.projMatrix * rContext.viewMatrix * transformMatrix;
-    ShaderSetMatrix4(rContext.boundShader, "uMvp", mvp);
+    RendererApplyDrawState(rContext.boundShader, texture, mvp);
 
     GLCall(glDrawArrays(mode, 0, count));
+    rContext.frameStats.drawCalls++;
 }
 
+/*
+    Records vertices in the render queue, vertices are transformed on the CPU so draws with different
+    transforms can share a single draw call. Strips, fans and loops are converted to lists.
+*/
 void RendererDraw(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture, Mat4 transformMatrix)
 {
+    RendererDrawVertices(mode, vertices, count, texture, transformMatrix, nullptr, nullptr);
+}
+
+/*
+    Same as above but every vertex is drawn with color, the vertex colors are ignored.
+*/
+void RendererDraw(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture, Mat4 transformMatrix,
+                  Color color)
+{
+    RendererDrawVertices(mode, vertices, count, texture, transformMatrix, &color, nullptr);
+}
+
+/*
+    Records vertices sampling a signed distance field texture, they are drawn with the built-in SDF shader
+    no matter which shader is bound. The distance is read from the alpha channel, 0.5 is the glyph edge.
+*/
+void RendererDrawSDF(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
+                     Mat4 transformMatrix)
+{
+    SASSERT_MSG(rContext.sdfShader.rendererID, "SDF shader is not available");
+    RendererDrawVertices(mode, vertices, count, texture, transformMatrix, nullptr, &rContext.sdfShader);
+}
+
+static void RendererDrawVertices(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
+                                 Mat4 transformMatrix, const Color* color, const Shader* shader)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
     SASSERT_MSG(vertices, "vertices can't be null");
+    SASSERT_MSG(texture, "texture can't be null");
 
-    VertexArray va = VertexArrayInit();
-    VertexArrayBind(va);
-    VertexBuffer vb = VertexBufferInit(vertices, count);
-    VertexBufferBind(vb);
-    VertexArrayAddBuffer(va, vb, &rContext.layout);
+    if (count == 0) {
+        return;
+    }
+
+    Vec2 boundsMin = vertices[0].position;
+    Vec2 boundsMax = boundsMin;
+    for (u32 i = 1; i < count; i++) {
+        boundsMin = Vector2Min(boundsMin, vertices[i].position);
+        boundsMax = Vector2Max(boundsMax, vertices[i].position);
+    }
+
+    // NOTE: Points and lines are rasterized wider than their vertices
+    if (BatchGetPrimitiveMode(mode) != TRIANGLES) {
+        Vec2 padding = { renderState.lineWidth, renderState.lineWidth };
+        boundsMin -= padding;
+        boundsMax += padding;
+    }
+
+    if (!RenderQueueIsVisible(boundsMin, boundsMax, transformMatrix)) {
+        return;
+    }
+
+    // NOTE: Reserves for the worst case, a fan or strip expands to three vertices per input vertex
+    RenderQueue* queue = RenderQueueGetThreadQueue();
+    RenderQueueReserve(queue, 3 * count, 0);
+    RenderCommand* command = RenderQueuePushCommand(RENDER_COMMAND_VERTICES, BatchGetPrimitiveMode(mode),
+                                                    nullptr, texture, shader);
+    u32 firstVertex = queue->vertexCount;
+
+    switch (mode) {
+        case POINTS:
+        case LINES:
+        case TRIANGLES: {
+            u32 primitiveSize = BatchGetPrimitiveSize(mode);
+            for (u32 i = 0; i + primitiveSize <= count; i += primitiveSize) {
+                u32 indices[] = { i, i + 1, i + 2 };
+                RenderQueuePushPrimitive(vertices, indices, primitiveSize, transformMatrix, color);
+            }
+        }
+            break;
+        case LINE_STRIP:
+        case LINE_LOOP: {
+            for (u32 i = 0; i + 1 < count; i++) {
+                u32 indices[] = { i, i + 1 };
+                RenderQueuePushPrimitive(vertices, indices, 2, transformMatrix, color);
+            }
+            if (mode == LINE_LOOP && count > 2) {
+                u32 indices[] = { count - 1, 0 };
+                RenderQueuePushPrimitive(vertices, indices, 2, transformMatrix, color);
+            }
+        }
+            break;
+        case TRIANGLE_STRIP: {
+            for (u32 i = 0; i + 2 < count; i++) {
+                // NOTE: Odd triangles are flipped to preserve the winding order
+                u32 indices[] = { (i & 1) ? i + 1 : i, (i & 1) ? i : i + 1, i + 2 };
+                RenderQueuePushPrimitive(vertices, indices, 3, transformMatrix, color);
+            }
+        }
+            break;
+        case TRIANGLE_FAN: {
+            for (u32 i = 1; i + 1 < count; i++) {
+                u32 indices[] = { 0, i, i + 1 };
+                RenderQueuePushPrimitive(vertices, indices, 3, transformMatrix, color);
+            }
+        }
+            break;
+        default: SASSERT_MSG(false, "Draw mode not supported!");
+            break;
+    }
+
+    command->count += queue->vertexCount - firstVertex;
+}
+
+/*
+    Records an instance of a unit mesh to the current batch, only the 2D affine part of the transform
+    is kept. texRect holds the min and max UVs the mesh texture coordinates are mapped to.
+*/
+void RendererDrawInstance(const Mesh* mesh, Mat4 transformMatrix, Vec4 texRect, Color color,
+                          const Texture2D* texture)
+{
+    SASSERT_MSG(isInit, "Renderer is not started");
+    SASSERT_MSG(mesh, "mesh can't be null");
+    SASSERT_MSG(texture, "texture can't be null");
+
+    if (!RenderQueueIsVisible(mesh->boundsMin, mesh->boundsMax, transformMatrix)) {
+        return;
+    }
+
+    RenderQueue* queue = RenderQueueGetThreadQueue();
+    RenderQueueReserve(queue, 0, 1);
+    RenderCommand* command = RenderQueuePushCommand(RENDER_COMMAND_INSTANCES, mesh->mode, mesh, texture, nullptr);
+
+    InstanceData* instance = &queue->instances[queue->instanceCount++];
+    instance->transformRow0 = Vec3{ transformMatrix.m0, transformMatrix.m1, transformMatrix.m3 };
+    instance->transformRow1 = Vec3{ transformMatrix.m4, transformMatrix.m5, transformMatrix.m7 };
+    instance->texRect = texRect;
+    instance->color = color;
+    instance->texIndex = 0.0f;
+
+    command->count++;
+}
+
+static void RendererApplyDrawState(Shader shader, const Texture2D* texture, Mat4 mvp)
+{
+    if (texture) {
+        TextureBind(texture, 0);
+    }
+
+    i32 mvpLocation = ShaderGetUniformLocation(shader, UNIFORM_ID("uMvp"));
+    if (mvpLocation != -1) {
+        GLCall(glUniformMatrix4fv(mvpLocation, 1, GL_TRUE, (f32*) mvp.f));
+    }
+}
+
+static void RendererApplyBlendMode(BlendMode blendMode)
+{
+    switch (blendMode) {
+        case BLEND_ALPHA: GLStateSetBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BLEND_ADDITIVE: GLStateSetBlend(true, GL_SRC_ALPHA, GL_ONE);
+            break;
+        case BLEND_MULTIPLY: GLStateSetBlend(true, GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BLEND_PREMULTIPLIED_ALPHA: GLStateSetBlend(true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        default: SASSERT_MSG(false, "Blend mode not supported!");
+            break;
+    }
+}
+
+static void RenderQueueInit(RenderQueue* queue)
+{
+    queue->commandCapacity = RENDERER_QUEUE_INITIAL_COMMANDS;
+    queue->commands = (RenderCommand*) SMalloc(queue->commandCapacity * sizeof(RenderCommand), MEMORY_TAG_RENDERER);
+    queue->sortKeys = (u64*) SMalloc(2 * queue->commandCapacity * sizeof(u64), MEMORY_TAG_RENDERER);
+    queue->sortIndices = (u32*) SMalloc(2 * queue->commandCapacity * sizeof(u32), MEMORY_TAG_RENDERER);
+    queue->vertexCapacity = RENDERER_BATCH_MAX_VERTICES;
+    queue->vertices = (BatchVertex*) SMalloc(queue->vertexCapacity * sizeof(BatchVertex), MEMORY_TAG_RENDERER);
+    queue->instanceCapacity = RENDERER_BATCH_MAX_INSTANCES;
+    queue->instances = (InstanceData*) SMalloc(queue->instanceCapacity * sizeof(InstanceData), MEMORY_TAG_RENDERER);
+}
+
+static void RenderQueueDelete(RenderQueue* queue)
+{
+    SFree(queue->commands);
+    SFree(queue->sortKeys);
+    SFree(queue->sortIndices);
+    SFree(queue->vertices);
+    SFree(queue->instances);
+    SMemZero(queue, sizeof(RenderQueue));
+}
+
+/*
+    Returns the queue draws of the calling thread are recorded into. The render thread records into
+    the main queue, worker threads take a queue from the free list until they submit it, along with
+    a copy of the published frame state.
+*/
+static RenderQueue* RenderQueueGetThreadQueue()
+{
+    if (threadQueue) {
+        return threadQueue;
+    }
+
+    std::lock_guard<std::mutex> lock(threadQueueMutex);
+    if (rContext.freeQueues) {
+        threadQueue = rContext.freeQueues;
+        rContext.freeQueues = threadQueue->next;
+        threadQueue->next = nullptr;
+    } else {
+        threadQueue = (RenderQueue*) SMalloc(sizeof(RenderQueue), MEMORY_TAG_RENDERER);
+        RenderQueueInit(threadQueue);
+    }
+    threadQueue->frameState = rContext.threadFrameState;
+    rContext.recordingQueueCount++;
+
+    return threadQueue;
+}
+
+/*
+    Appends the queues submitted by worker threads to the main queue, so the next flush sorts them together
+    with the main thread draws. Worker commands carry the default shader so the bound shader doesn't matter.
+*/
+static void RenderQueueMergePending()
+{
+    RenderQueue* pending = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(threadQueueMutex);
+        pending = rContext.pendingQueues;
+        rContext.pendingQueues = nullptr;
+        rContext.pendingQueuesTail = nullptr;
+    }
+
+    if (!pending) {
+        return;
+    }
+
+    RenderQueue* queue = &rContext.queue;
+    RenderQueue* last = pending;
+    for (RenderQueue* src = pending; src != nullptr; src = src->next) {
+        RenderQueueReserveCommands(queue, src->commandCount);
+        RenderQueueReserve(queue, src->vertexCount, src->instanceCount);
+
+        // NOTE: Worker draws come after the main thread draws with the same layer and depth
+        for (u32 i = 0; i < src->commandCount; i++) {
+            RenderCommand* command = &queue->commands[queue->commandCount];
+            *command = src->commands[i];
+            command->key = (command->key & 0xFFFFFFFF00000000ull) | queue->commandCount++;
+            command->first += (command->type == RENDER_COMMAND_INSTANCES) ? queue->instanceCount : queue->vertexCount;
+        }
+
+        SMemCopy(queue->vertices + queue->vertexCount, src->vertices, src->vertexCount * sizeof(BatchVertex));
+        SMemCopy(queue->instances + queue->instanceCount, src->instances, src->instanceCount * sizeof(InstanceData));
+        queue->vertexCount += src->vertexCount;
+        queue->instanceCount += src->instanceCount;
+        queue->submittedPrimitives += src->submittedPrimitives;
+        queue->culledPrimitives += src->culledPrimitives;
+
+        src->commandCount = 0;
+        src->vertexCount = 0;
+        src->instanceCount = 0;
+        src->submittedPrimitives = 0;
+        src->culledPrimitives = 0;
+        last = src;
+    }
+
+    std::lock_guard<std::mutex> lock(threadQueueMutex);
+    last->next = rContext.freeQueues;
+    rContext.freeQueues = pending;
+}
+
+// NOTE: The view and instancing toggle are only written by the render thread, workers read this copy
+static void RenderQueuePublishFrameState()
+{
+    std::lock_guard<std::mutex> lock(threadQueueMutex);
+    rContext.threadFrameState.viewProjMatrix = rContext.viewProjMatrix;
+    rContext.threadFrameState.instancing = rContext.instancing;
+}
+
+static bool8 RenderQueueIsBaking()
+{
+    return isRenderThread && threadQueue != &rContext.queue;
+}
+
+static bool8 RenderQueueReferences(const RenderQueue* queue, const Texture2D* texture, const Mesh* mesh)
+{
+    for (u32 i = 0; i < queue->commandCount; i++) {
+        const RenderCommand* command = &queue->commands[i];
+        if ((texture && command->texture == texture) || (mesh && command->mesh == mesh)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Conservative visibility test of the transformed bounds against the clip volume of the current
+    projection and view. The draw is culled only when every corner is outside the same clip plane,
+    so draws crossing a corner of the screen are kept. Counts the result in the thread queue.
+*/
+static bool8 RenderQueueIsVisible(Vec2 boundsMin, Vec2 boundsMax, Mat4 transformMatrix)
+{
+    // NOTE: Baked layers are drawn with their own transform, culling is left to the caller
+    if (RenderQueueIsBaking()) {
+        return true;
+    }
+
+    const Mat4 vp = isRenderThread ? rContext.viewProjMatrix : RenderQueueGetThreadQueue()->frameState.viewProjMatrix;
+    const Vec2 corners[] = {
+        { boundsMin.x, boundsMin.y },
+        { boundsMax.x, boundsMin.y },
+        { boundsMin.x, boundsMax.y },
+        { boundsMax.x, boundsMax.y }
+    };
+
+    u32 outside = 0xF;
+    for (u32 i = 0; i < ARRAYCOUNT(corners); i++) {
+        f32 x = transformMatrix.m0 * corners[i].x + transformMatrix.m1 * corners[i].y + transformMatrix.m3;
+        f32 y = transformMatrix.m4 * corners[i].x + transformMatrix.m5 * corners[i].y + transformMatrix.m7;
+
+        f32 clipX = vp.m0 * x + vp.m1 * y + vp.m3;
+        f32 clipY = vp.m4 * x + vp.m5 * y + vp.m7;
+        f32 clipW = vp.m12 * x + vp.m13 * y + vp.m15;
+
+        u32 code = 0;
+        code |= (clipX < -clipW) ? 0x1 : 0;
+        code |= (clipX > clipW) ? 0x2 : 0;
+        code |= (clipY < -clipW) ? 0x4 : 0;
+        code |= (clipY > clipW) ? 0x8 : 0;
+        outside &= code;
+    }
+
+    RenderQueue* queue = RenderQueueGetThreadQueue();
+    if (outside) {
+        queue->culledPrimitives++;
+        return false;
+    }
+
+    queue->submittedPrimitives++;
+    return true;
+}
+
+/*
+    Packs the sort key of a command, from the most significant bits:
+    layer (8) | depth (24) | sequence (32)
+    sequence is the index of the command in its queue, overlapping blended draws with the same layer and depth
+    keep the painter's order. Commands sharing state are still merged into one batch when they are adjacent,
+    draws with different textures share a batch through the texture slots.
+*/
+static u64 RenderQueueGetKey(u32 sequence)
+{
+    u64 key = 0;
+    key |= (u64) renderState.layer << 56;
+    key |= (u64) (renderState.depth & 0xFFFFFF) << 32;
+    key |= (u64) sequence;
 
-    RendererDraw(mode, va, count, texture, transformMatrix);
+    return key;
+}
+
+/*
+    Returns the command the next draw is recorded into, the previous command is extended
+    when the draw would be submitted with the same state right after it anyway
+*/
+static RenderCommand* RenderQueuePushCommand(u32 type, DrawMode mode, const Mesh* mesh, const Texture2D* texture,
+                                             const Shader* shader)
+{
+    RenderQueue* queue = RenderQueueGetThreadQueue();
+
+    // NOTE: The bound shader on the render thread, copied into the command along with its uniform table
+    if (type == RENDER_COMMAND_INSTANCES) {
+        shader = &rContext.instanceShader;
+    } else if (!shader) {
+        shader = isRenderThread ? &rContext.boundShader : &defaultShader;
+    }
+    u64 key = RenderQueueGetKey(queue->commandCount);
+
+    // NOTE: Only the layer and depth have to match, the sequence of the last command is kept
+    if (queue->commandCount > 0) {
+        RenderCommand* last = &queue->commands[queue->commandCount - 1];
+        bool8 sameLineWidth = !(last->lineWidth < renderState.lineWidth || last->lineWidth > renderState.lineWidth);
+        if ((last->key >> 32) == (key >> 32) && last->type == type && last->mode == mode && last->mesh == mesh &&
+            last->texture == texture && last->blendMode == renderState.blendMode && sameLineWidth &&
+            last->shader.rendererID == shader->rendererID) {
+            return last;
+        }
+    }
+
+    RenderQueueReserveCommands(queue, 1);
+
+    RenderCommand* command = &queue->commands[queue->commandCount++];
+    command->key = key;
+    command->type = type;
+    command->shader = *shader;
+    command->mode = mode;
+    command->mesh = mesh;
+    command->texture = texture;
+    command->blendMode = renderState.blendMode;
+    command->lineWidth = renderState.lineWidth;
+    command->first = (type == RENDER_COMMAND_INSTANCES) ? queue->instanceCount : queue->vertexCount;
+    command->count = 0;
+
+    return command;
+}
+
+static void RenderQueueReserveCommands(RenderQueue* queue, u32 commandCount)
+{
+    if (queue->commandCount + commandCount > queue->commandCapacity) {
+        queue->commandCapacity = 2 * queue->commandCapacity;
+        if (queue->commandCapacity < queue->commandCount + commandCount) {
+            queue->commandCapacity = queue->commandCount + commandCount;
+        }
+        queue->commands = (RenderCommand*) SRealloc(queue->commands, queue->commandCapacity * sizeof(RenderCommand),
+                                                    MEMORY_TAG_RENDERER);
+        queue->sortKeys = (u64*) SRealloc(queue->sortKeys, 2 * queue->commandCapacity * sizeof(u64),
+                                          MEMORY_TAG_RENDERER);
+        queue->sortIndices = (u32*) SRealloc(queue->sortIndices, 2 * queue->commandCapacity * sizeof(u32),
+                                             MEMORY_TAG_RENDERER);
+    }
+}
+
+static void RenderQueueReserve(RenderQueue* queue, u32 vertexCount, u32 instanceCount)
+{
+    if (queue->vertexCount + vertexCount > queue->vertexCapacity) {
+        queue->vertexCapacity = 2 * queue->vertexCapacity;
+        if (queue->vertexCapacity < queue->vertexCount + vertexCount) {
+            queue->vertexCapacity = queue->vertexCount + vertexCount;
+        }
+        queue->vertices = (BatchVertex*) SRealloc(queue->vertices, queue->vertexCapacity * sizeof(BatchVertex),
+                                                  MEMORY_TAG_RENDERER);
+    }
+
+    if (queue->instanceCount + instanceCount > queue->instanceCapacity) {
+        queue->instanceCapacity = 2 * queue->instanceCapacity;
+        if (queue->instanceCapacity < queue->instanceCount + instanceCount) {
+            queue->instanceCapacity = queue->instanceCount + instanceCount;
+        }
+        queue->instances = (InstanceData*) SRealloc(queue->instances, queue->instanceCapacity * sizeof(InstanceData),
+                                                    MEMORY_TAG_RENDERER);
+    }
+}
+
+// NOTE: A null color keeps the color of each vertex
+static void RenderQueuePushPrimitive(const Vertex* vertices, const u32* indices, u32 count, Mat4 transformMatrix,
+                                     const Color* color)
+{
+    RenderQueue* queue = RenderQueueGetThreadQueue();
+
+    BatchVertex* dst = queue->vertices + queue->vertexCount;
+    for (u32 i = 0; i < count; i++) {
+        const Vertex* src = &vertices[indices[i]];
+        dst[i].position.x = transformMatrix.m0 * src->position.x + transformMatrix.m1 * src->position.y +
+                            transformMatrix.m3;
+        dst[i].position.y = transformMatrix.m4 * src->position.x + transformMatrix.m5 * src->position.y +
+                            transformMatrix.m7;
+        dst[i].texCord = src->texCord;
+        dst[i].color = color ? *color : src->color;
+        dst[i].texIndex = 0.0f;
+    }
+
+    queue->vertexCount += count;
+}
+
+/*
+    Copies a sorted command into the GPU batch, the batch is submitted when the command needs
+    different state or doesn't fit. Texture indices are only known here and are patched while copying.
+
+    Draws are recorded into the queue first since they can only be written in order once the frame is sorted.
+    The mapped stream is write-combined, so every element is written to it once and never read back.
+*/
+static void RenderQueueSubmitCommand(const RenderCommand* command)
+{
+    RenderBatch* batch = &rContext.batch;
+    RenderQueue* queue = &rContext.queue;
+
+    if (batch->vertexCount > 0 || batch->instanceCount > 0) {
+        bool8 sameState = batch->type == command->type && batch->blendMode == command->blendMode &&
+                          batch->shader.rendererID == command->shader.rendererID;
+        if (command->type == RENDER_COMMAND_INSTANCES) {
+            sameState = sameState && batch->mesh == command->mesh;
+        } else {
+            sameState = sameState && batch->mode == command->mode;
+            if (command->mode == LINES) {
+                sameState = sameState && !(batch->lineWidth < command->lineWidth ||
+                                           batch->lineWidth > command->lineWidth);
+            }
+        }
 
-    VertexBufferDelete(&vb);
-    VertexArrayDelete(&va);
-}
\ No newline at end of file
+        if (!sameState) {
+            BatchSubmit();
+        }
+    }
+
+    batch->type = command->type;
+    batch->shader = command->shader;
+    batch->mode = command->mode;
+    batch->mesh = command->mesh;
+    batch->blendMode = command->blendMode;
+    batch->lineWidth = command->lineWidth;
+
+    u32 submitted = 0;
+    while (submitted < command->count) {
+        bool8 isInstanced = command->type == RENDER_COMMAND_INSTANCES;
+        u32 used = isInstanced ? batch->instanceCount : batch->vertexCount;
+        u32 capacity = isInstanced ? batch->instanceCapacity : batch->vertexCapacity;
+        if (used >= capacity) {
+            BatchSubmit();
+        }
+
+        f32 texIndex = (f32) BatchGetTextureSlot(command->texture);
+        BatchMap();
+
+        used = isInstanced ? batch->instanceCount : batch->vertexCount;
+        u32 count = command->count - submitted;
+        if (count > capacity - used) {
+            count = capacity - used;
+        }
+
+        if (isInstanced) {
+            InstanceData* dst = batch->instances + batch->instanceCount;
+            const InstanceData* src = queue->instances + command->first + submitted;
+            for (u32 i = 0; i < count; i++) {
+                InstanceData instance = src[i];
+                instance.texIndex = texIndex;
+                dst[i] = instance;
+            }
+
+            batch->instanceCount += count;
+            submitted += count;
+        } else {
+            // NOTE: The batch capacity is a multiple of every primitive size, so primitives are never split
+            BatchVertex* dst = batch->vertices + batch->vertexCount;
+            const BatchVertex* src = queue->vertices + command->first + submitted;
+            for (u32 i = 0; i < count; i++) {
+                BatchVertex vertex = src[i];
+                vertex.texIndex = texIndex;
+                dst[i] = vertex;
+            }
+
+            batch->vertexCount += count;
+            submitted += count;
+        }
+    }
+}
+
+static DrawMode BatchGetPrimitiveMode(DrawMode mode)
+{
+    switch (mode) {
+        case POINTS: return POINTS;
+        case LINES:
+        case LINE_STRIP:
+        case LINE_LOOP: return LINES;
+        case TRIANGLES:
+        case TRIANGLE_STRIP:
+        case TRIANGLE_FAN: return TRIANGLES;
+    }
+    SASSERT_MSG(false, "Draw mode not supported!");
+    return TRIANGLES;
+}
+
+static u32 BatchGetPrimitiveSize(DrawMode mode)
+{
+    switch (BatchGetPrimitiveMode(mode)) {
+        case POINTS: return 1;
+        case LINES: return 2;
+        case TRIANGLES: return 3;
+    }
+    return 3;
+}
+
+/*
+    Returns the slot the texture is bound to in the current batch, submitting first when every slot is taken
+*/
+static u32 BatchGetTextureSlot(const Texture2D* texture)
+{
+    RenderBatch* batch = &rContext.batch;
+
+    for (u32 slot = 0; slot < batch->textureCount; slot++) {
+        if (batch->textures[slot] == texture) {
+            return slot;
+        }
+    }
+
+    if (batch->textureCount >= rContext.textureSlotCount) {
+        BatchSubmit();
+    }
+
+    batch->textures[batch->textureCount] = texture;
+    return batch->textureCount++;
+}
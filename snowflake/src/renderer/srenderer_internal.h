@@ -3,14 +3,39 @@
 #include "core/defines.h"
 #include "math/smath.h"
 #include "texture.h"
+#include "utils/utils.h"
 
 #include <GL/glew.h>
 
+/*
+    OpenGL error checking levels, selected with SNOWFLAKE_GL_CHECK_LEVEL:
+    NONE            GLCall is the bare call
+    CALLBACK_ASYNC  errors are reported by the driver through KHR_debug, possibly after the call returned
+    CALLBACK_SYNC   same as above, but the callback runs inside the failing call so the stack is meaningful
+    GET_ERROR       every GLCall is wrapped with glGetError, which may stall the pipeline
+*/
+#define SNOWFLAKE_GL_CHECK_NONE 0
+#define SNOWFLAKE_GL_CHECK_CALLBACK_ASYNC 1
+#define SNOWFLAKE_GL_CHECK_CALLBACK_SYNC 2
+#define SNOWFLAKE_GL_CHECK_GET_ERROR 3
+
+#ifndef SNOWFLAKE_GL_CHECK_LEVEL
+#ifdef SNOWFLAKE_DEBUG
+#define SNOWFLAKE_GL_CHECK_LEVEL SNOWFLAKE_GL_CHECK_GET_ERROR
+#else
+#define SNOWFLAKE_GL_CHECK_LEVEL SNOWFLAKE_GL_CHECK_NONE
+#endif
+#endif
+
 #ifndef GLCall
+#if SNOWFLAKE_GL_CHECK_LEVEL == SNOWFLAKE_GL_CHECK_GET_ERROR
 #define GLCall(x)                                                  \
         GLClearError();                                            \
         x;                                                         \
         SASSERT(GLLogCall(#x))
+#else
+#define GLCall(x) x
+#endif
 #endif
 
 typedef i32 DrawMode;
@@ -25,6 +50,15 @@ enum SAPI DrawModes {
     TRIANGLES = GL_TRIANGLES
 };
 
+typedef i32 BlendMode;
+
+enum SAPI BlendModes {
+    BLEND_ALPHA,
+    BLEND_ADDITIVE,
+    BLEND_MULTIPLY,
+    BLEND_PREMULTIPLIED_ALPHA
+};
+
 struct SAPI VertexBuffer {
     u32 rendererID;
 };
@@ -38,6 +72,24 @@ struct SAPI VertexArray {
     u32 rendererID;
 };
 
+struct SAPI GPUFence {
+    GLsync sync;
+};
+
+#define STREAM_BUFFER_REGION_COUNT 3
+#define STREAM_BUFFER_WAIT_TIMEOUT 1000000
+
+struct SAPI StreamBuffer {
+    VertexBuffer vb;
+    u8* mapped;
+    u32 size;
+    u32 regionSize;
+    u32 region;
+    u32 head;
+    GPUFence fences[STREAM_BUFFER_REGION_COUNT];
+    bool8 persistent;
+};
+
 struct SAPI VertexBufferElement {
     u32 type;
     u32 count;
@@ -55,28 +107,141 @@ struct SAPI VertexBufferLayout {
 struct SAPI Vertex {
     Vec2 position;
     Vec2 texCord;
+    Color color;
+};
+
+// NOTE: Unit geometry kept on the GPU, drawn once per instance of the batch
+struct SAPI BakedLayer;
+
+struct SAPI Mesh {
+    VertexArray va;
+    VertexBuffer vb;
+    DrawMode mode;
+    u32 vertexCount;
+    Vec2 boundsMin;
+    Vec2 boundsMax;
+};
+
+// NOTE: Unit shape vertices kept in CPU memory for batching and on the GPU for instancing, colored white
+struct SAPI CachedGeometry {
+    Vertex* vertices;
+    u32 vertexCount;
+    DrawMode mode;
+    Mesh mesh;
+};
+
+// NOTE: Counters of the last completed frame, elided state changes were skipped by the GL state cache
+struct SAPI RendererStats {
+    u32 commands;
+    u32 drawCalls;
+    u32 streamWaits;
+    u32 stateChanges;
+    u32 elidedStateChanges;
+    u32 submittedPrimitives;
+    u32 culledPrimitives;
+};
+
+struct SAPI UniformID {
+    u32 hash;
+};
+
+template<u32 hash>
+struct UniformIDConstant {
+    static constexpr UniformID value = { hash };
+};
+
+// NOTE: Forces the uniform name to be hashed at compile time
+#define UNIFORM_ID(name) (UniformIDConstant<StringHash(name)>::value)
+
+struct SAPI ShaderUniform {
+    u32 hash;
+    i32 location;
 };
 
 struct SAPI Shader {
     u32 rendererID;
     char* vsFilePath;
     char* fsFilePath;
+    ShaderUniform* uniforms;
+    u32 uniformCapacity;
 };
 
 void GLClearError();
 bool8 GLLogCall(const char* function);
 
+void GLStateUseProgram(u32 program);
+void GLStateBindVertexArray(u32 vertexArray);
+void GLStateBindBuffer(u32 target, u32 buffer);
+void GLStateBindTexture(u32 texture, u32 slot);
+void GLStateUnbindTexture();
+void GLStateSetBlend(bool8 enabled, u32 srcFactor, u32 dstFactor);
+void GLStateSetViewport(i32 x, i32 y, i32 width, i32 height);
+void GLStateInvalidateProgram(u32 program);
+void GLStateInvalidateVertexArray(u32 vertexArray);
+void GLStateInvalidateBuffer(u32 buffer);
+void GLStateInvalidateTexture(u32 texture);
+
 void RendererStartup(f32 width, f32 height);
 void RendererShutdown();
+void RendererEndFrame();
+void FontStartup();
+void FontShutdown();
+void FontUpdateGlyphCaches();
+bool8 RendererHasThreadCommands();
 SAPI void RendererCreateViewport(f32 width, f32 height);
+SAPI void RendererSetViewMatrix(Mat4 viewMatrix);
 SAPI void RendererSetPolygonMode(u32 face, u32 mode);
+SAPI void RendererFlush();
+SAPI RendererStats RendererGetStats();
+SAPI void RendererSetLayer(u8 layer);
+SAPI u8 RendererGetLayer();
+SAPI void RendererSetDepth(f32 depth);
+SAPI void RendererSetBlendMode(BlendMode blendMode);
+SAPI BlendMode RendererGetBlendMode();
+void RendererSetLineWidth(f32 width);
+SAPI const Texture2D* RendererGetDefaultTexture();
+SAPI u32 RendererGetTextureSlotCount();
+void RendererFlushTexture(const Texture2D* texture);
+void RendererReleaseTexture(const Texture2D* texture);
+SAPI bool8 RendererIsRenderThread();
+SAPI void RendererSubmitThreadCommands();
+
+SAPI void RendererSetInstancing(bool8 enabled);
+SAPI bool8 RendererIsInstancingActive();
+SAPI const Mesh* RendererGetQuadMesh();
+SAPI const CachedGeometry* RendererGetCircleGeometry(u32 pointCount);
+SAPI const CachedGeometry* RendererGetRingGeometry(u32 quadCount, f32 innerRatio);
+
+SAPI Mesh MeshInit(DrawMode mode, const Vertex* vertices, u32 count);
+SAPI void MeshDelete(Mesh* mesh);
+
+SAPI BakedLayer* BakedLayerCreate();
+SAPI void BakedLayerDelete(BakedLayer** layer);
+SAPI void BakedLayerBegin(BakedLayer* layer);
+SAPI void BakedLayerEnd(BakedLayer* layer);
+SAPI void BakedLayerMarkDirty(BakedLayer* layer);
+SAPI bool8 BakedLayerIsDirty(const BakedLayer* layer);
+SAPI void BakedLayerDraw(const BakedLayer* layer, Mat4 transformMatrix);
 
 SAPI VertexBuffer VertexBufferInit(const void* data, u32 size);
 SAPI VertexBuffer VertexBufferInit(const Vertex* data, u32 count);
+SAPI VertexBuffer VertexBufferInitDynamic(u32 size);
+SAPI void VertexBufferSetData(VertexBuffer vb, const void* data, u32 size, u32 offset);
 SAPI void VertexBufferDelete(VertexBuffer* vb);
 SAPI void VertexBufferBind(VertexBuffer vb);
 SAPI void VertexBufferUnbind();
 
+SAPI StreamBuffer StreamBufferInit(u32 regionSize);
+SAPI void StreamBufferDelete(StreamBuffer* stream);
+SAPI void* StreamBufferMap(StreamBuffer* stream, u32 size, u32 alignment, u32* outOffset);
+SAPI void StreamBufferUnmap(StreamBuffer* stream, u32 usedSize);
+SAPI void StreamBufferAdvance(StreamBuffer* stream);
+
+SAPI GPUFence GPUFenceCreate();
+SAPI void GPUFenceDelete(GPUFence* fence);
+SAPI bool8 GPUFenceIsSignaled(GPUFence fence);
+SAPI void GPUFenceWait(GPUFence fence);
+
 SAPI IndexBuffer IndexBufferInit(const u32* data, u32 count);
 SAPI void IndexBufferDelete(IndexBuffer* ib);
 SAPI void IndexBufferBind(IndexBuffer ib);
@@ -87,6 +252,8 @@ SAPI void VertexArrayDelete(VertexArray* va);
 SAPI void VertexArrayBind(VertexArray va);
 SAPI void VertexArrayUnbind();
 SAPI void VertexArrayAddBuffer(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout);
+SAPI void VertexArrayAddInstanceBuffer(VertexArray va, VertexBuffer vb, const VertexBufferLayout* layout,
+                                       u32 firstAttribute);
 
 SAPI VertexBufferLayout VertexBufferLayoutInit();
 SAPI void VertexBufferLayoutDelete(VertexBufferLayout* layout);
@@ -94,6 +261,7 @@ SAPI void VertexBufferLayoutPushFloat(VertexBufferLayout* layout, u32 count);
 SAPI void VertexBufferLayoutPushUInt(VertexBufferLayout* layout, u32 count);
 SAPI void VertexBufferLayoutPushUByte(VertexBufferLayout* layout, u32 count);
 SAPI void VertexBufferLayoutPushVec2(VertexBufferLayout* layout, u32 count);
+SAPI void VertexBufferLayoutPushColor(VertexBufferLayout* layout, u32 count);
 
 SAPI Shader ShaderLoadFromFiles(const char* vsFilePath, const char* fsFilePath);
 SAPI Shader ShaderLoadFromMemory(const char* vsShader, const char* fsShader);
@@ -102,6 +270,9 @@ SAPI void ShaderUnload(Shader* shader);
 SAPI void ShaderBind(Shader shader);
 SAPI void ShaderUnbind();
 SAPI Shader* ShaderGetBound();
+SAPI UniformID ShaderGetUniformID(const char* uniformName);
+SAPI bool8 ShaderHasUniform(Shader shader, UniformID uniform);
+SAPI i32 ShaderGetUniformLocation(Shader shader, UniformID uniform);
 SAPI void ShaderSetUniform1f(Shader shader, const char* uniformName, f32 v);
 SAPI void ShaderSetUniform2f(Shader shader, const char* uniformName, f32 v0, f32 v1);
 SAPI void ShaderSetUniform3f(Shader shader, const char* uniformName, f32 v0, f32 v1, f32 v2);
@@ -113,8 +284,25 @@ SAPI void ShaderSetUniformVec4(Shader shader, const char* uniformName, Vec4 v);
 SAPI void ShaderSetMatrix2(Shader shader, const char* uniformName, Mat2 mat);
 SAPI void ShaderSetMatrix3(Shader shader, const char* uniformName, Mat3 mat);
 SAPI void ShaderSetMatrix4(Shader shader, const char* uniformName, Mat4 mat);
+SAPI void ShaderSetUniform1f(Shader shader, UniformID uniform, f32 v);
+SAPI void ShaderSetUniform2f(Shader shader, UniformID uniform, f32 v0, f32 v1);
+SAPI void ShaderSetUniform3f(Shader shader, UniformID uniform, f32 v0, f32 v1, f32 v2);
+SAPI void ShaderSetUniform4f(Shader shader, UniformID uniform, f32 v0, f32 v1, f32 v2, f32 v3);
+SAPI void ShaderSetUniform1i(Shader shader, UniformID uniform, i32 v);
+SAPI void ShaderSetUniformVec2(Shader shader, UniformID uniform, Vec2 v);
+SAPI void ShaderSetUniformVec3(Shader shader, UniformID uniform, Vec3 v);
+SAPI void ShaderSetUniformVec4(Shader shader, UniformID uniform, Vec4 v);
+SAPI void ShaderSetMatrix2(Shader shader, UniformID uniform, Mat2 mat);
+SAPI void ShaderSetMatrix3(Shader shader, UniformID uniform, Mat3 mat);
+SAPI void ShaderSetMatrix4(Shader shader, UniformID uniform, Mat4 mat);
 
 SAPI void RendererDraw(DrawMode mode, VertexArray va, IndexBuffer ib, const Texture2D* texture, Mat4 transformMatrix);
 SAPI void RendererDraw(DrawMode mode, VertexArray va, u32 count, const Texture2D* texture, Mat4 transformMatrix);
 SAPI void RendererDraw(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
-                       Mat4 transformMatrix);
\ No newline at end of file
+                       Mat4 transformMatrix);
+SAPI void RendererDraw(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
+                       Mat4 transformMatrix, Color color);
+SAPI void RendererDrawSDF(DrawMode mode, const Vertex* vertices, u32 count, const Texture2D* texture,
+                          Mat4 transformMatrix);
+SAPI void RendererDrawInstance(const Mesh* mesh, Mat4 transformMatrix, Vec4 texRect, Color color,
+                               const Texture2D* texture);
@@ -2,102 +2,401 @@
 #include "core/logger.h"
 #include "core/sassert.h"
 #include "core/smemory.h"
+#include "platform/platform.h"
+#include "rect_packer.h"
 #include "srenderer_internal.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
-struct Glyph {
-    u32 width;
-    u32 height;
-    i32 bearingX;
-    i32 bearingY;
-    u32 advance;
-    Image* bitmap;
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#define FONT_ATLAS_PAGES_PER_SIDE 2
+#define FONT_ATLAS_PAGE_COUNT (FONT_ATLAS_PAGES_PER_SIDE * FONT_ATLAS_PAGES_PER_SIDE)
+#define FONT_ATLAS_MAX_PAGE_SIZE 8192
+#define FONT_GLYPH_PADDING 5
+#define FONT_GLYPH_FRAME_BUDGET 64
+#define FONT_RASTER_MAX_THREADS 8
+#define FONT_RASTER_GLYPHS_PER_THREAD 16
+#define FONT_GLYPH_NONE 0xFFFFFFFF
+#define FONT_CACHE_MAGIC 0x43464E53
+#define FONT_CACHE_VERSION 3
+#define FONT_CACHE_MAX_PATH 512
+#define FONT_KERNING_FIRST_CODEPOINT 32
+#define FONT_KERNING_LAST_CODEPOINT 255
+
+enum GlyphFlags {
+    GLYPH_FLAG_LOADED = 1 << 0,
+    GLYPH_FLAG_PENDING = 1 << 1
 };
 
+// NOTE: advance is in whole pixels, width and height are the size of the glyph bitmap
+struct GlyphMetrics {
+    u16 width;
+    u16 height;
+    i16 bearingX;
+    i16 bearingY;
+    u16 advance;
+};
+
+// NOTE: page is -1 while the glyph isn't in the atlas, its metrics stay valid once it has been loaded
+struct GlyphPlacement {
+    u16 left;
+    u16 top;
+    i8 page;
+    u8 flags;
+};
+
+// NOTE: The dirty rect is in page space, empty when dirtyRight <= dirtyLeft
+struct GlyphCachePage {
+    RectPacker* packer;
+    i32 left;
+    i32 top;
+    u64 lastUsedFrame;
+    i32 dirtyLeft;
+    i32 dirtyTop;
+    i32 dirtyRight;
+    i32 dirtyBottom;
+};
+
+/*
+    Glyphs are rasterized on demand. Lookups go through an open addressing table of glyph indices keyed by
+    codepoint, missing glyphs are queued and rasterized in batches at the end of the frame.
+    The atlas is split in pages laid out on a FONT_ATLAS_PAGES_PER_SIDE grid, it starts as a single page and
+    grows as pages are opened. Once every page is full the least recently drawn one is evicted.
+    Glyph data is stored as parallel arrays, probing only touches codepoints and layout metrics and placements.
+    atlasPixels is the coverage of the atlas in use, glyphs are composed into it and uploaded once per batch.
+    The atlas texture is single channel, so the dirty rects are uploaded straight from atlasPixels.
+*/
+struct GlyphCache {
+    u32* codepoints;
+    GlyphMetrics* metrics;
+    GlyphPlacement* placements;
+    u32 glyphCount;
+    u32 glyphCapacity;
+    u32* slots;
+    u32 slotCapacity;
+    u32* pending;
+    u32 pendingCount;
+    u32 pendingCapacity;
+    GlyphCachePage pages[FONT_ATLAS_PAGE_COUNT];
+    u32 pageCount;
+    u32 currentPage;
+    i32 pageWidth;
+    i32 pageHeight;
+    u8* atlasPixels;
+    i32 atlasWidth;
+    i32 atlasHeight;
+    u64 frame;
+    u32 generation;
+    u32 evictions;
+    u32 resizes;
+};
+
+// NOTE: Glyphs rasterized on the CPU and waiting for the atlas, sorted tallest first. bitmaps hold coverage
+struct GlyphBatch {
+    u32* glyphIndices;
+    u8** bitmaps;
+    u32 count;
+};
+
+/*
+    Pair adjustments in 1/64 pixels at the base size keyed by (left << 32 | right) codepoints, read once when
+    the font is loaded. Open addressing like the glyph cache, key 0 marks an empty slot.
+*/
+struct KerningTable {
+    u64* keys;
+    i16* adjustments;
+    u32 capacity;
+    u32 count;
+};
+
+/*
+    faces[i] belongs to rasterizer thread i, every face is opened from the font file kept in memory.
+    ascender and descender are in 1/64 pixels at the base size, descender is below the baseline so negative.
+*/
 struct Font {
     char* familyName;
     u32 baseSize;
-    i32 glyphCount;
-    Glyph* glyphTable;
+    i32 ascender;
+    i32 descender;
+    FontRenderMode renderMode;
+    u8* fileData;
+    u64 fileSize;
+    FT_Face faces[FONT_RASTER_MAX_THREADS];
     Texture2D* texture;
-    Rectanglei* texRects;
+    GlyphCache* cache;
+    KerningTable kerning;
+    Font* next;
 };
 
+// NOTE: What a loader thread hands to the calling thread, fonts read from the atlas cache have an empty batch
+struct FontLoadState {
+    GlyphBatch batch;
+    u64 fileHash;
+    bool8 fromCache;
+};
+
+/*
+    Header of a baked atlas file, followed by the codepoints, metrics and placements of every glyph, the
+    coverage of the first atlas page row by row, the family name and the keys then adjustments of the kerning
+    pairs. The file is only valid for the font file with the same fileHash, the name of the cache file holds
+    the font path and the base size.
+*/
+struct FontCacheHeader {
+    u32 magic;
+    u32 version;
+    u64 fileHash;
+    u32 baseSize;
+    FontRenderMode renderMode;
+    i32 ascender;
+    i32 descender;
+    i32 pageWidth;
+    i32 pageHeight;
+    u32 glyphCount;
+    u32 familyNameLength;
+    u32 kerningCount;
+};
+
+/*
+    vertices hold the laid out glyph quads relative to the pen origin, rebuilt when the layout changes along
+    with bounds. generation, evictions and resizes are the glyph cache counters the layout was built against.
+*/
 struct Text {
     const Font* font;
     char* string;
     u32 characterSize;
     Color fillColor;
+    Vertex* vertices;
+    u32 vertexCount;
+    u32 pageMask;
+    u32 generation;
+    u32 evictions;
+    u32 resizes;
+    TextBounds bounds;
+    bool8 missingGlyphs;
 };
 
-static Texture2D* FontGenerateFontAtlas(Glyph* glyphs, Rectanglei** texRects, i32 glyphCount, u32 baseFontSize);
-static Glyph FontGetGlyph(FT_Face face, u8 glyphID);
-
-Font* FontLoadFromFile(const char* filePath, u32 baseSize)
+static u32 GlyphCacheFind(const GlyphCache* cache, u32 codepoint);
+static u32 GlyphCacheInsert(GlyphCache* cache, u32 codepoint);
+static void GlyphCacheLink(GlyphCache* cache, u32 glyphIndex);
+static Font* FontLoadPrepare(const FontLoadInfo* info, u32 threadCount, FontLoadState* state);
+static bool8 FontCacheLoad(Font* font, const char* filePath, u64 fileHash);
+static void FontCacheSave(const Font* font, const char* filePath, u64 fileHash);
+static void FontCacheGetPath(const char* filePath, u32 baseSize, FontRenderMode renderMode, char* outPath);
+static FT_Face FontGetFace(Font* font, u32 thread);
+static void FontLoadKerning(Font* font, FT_Face face);
+static i32 FontGetKerning(const Font* font, u32 left, u32 right);
+static void KerningTableInsert(KerningTable* table, u64 key, i16 adjustment);
+static u32 FontGetHardwareThreads();
+static u32 FontRequestGlyph(const Font* font, u32 codepoint);
+static void FontRasterizeBatch(Font* font, u32 budget, u32 threadCount, GlyphBatch* batch);
+static void FontUploadBatch(Font* font, GlyphBatch* batch, bool8 canRepack);
+static bool8 FontCreateAtlas(Font* font, const u32* glyphIndices, u32 count);
+static void FontCreateAtlasTexture(Font* font);
+static void FontCreatePages(GlyphCache* cache, i32 pageWidth, i32 pageHeight);
+static void FontGrowAtlas(GlyphCache* cache);
+static bool8 FontPackGlyph(Font* font, u32 glyphIndex, bool8 canRepack);
+static void FontEvictPage(Font* font, u32 page);
+static void FontMarkDirty(GlyphCache* cache, u32 page, i32 left, i32 top, i32 width, i32 height);
+static void FontClearDirty(GlyphCache* cache);
+static void FontUploadDirtyPages(Font* font);
+static u8* FontRasterizeGlyph(FT_Face face, FontRenderMode renderMode, u32 codepoint, GlyphMetrics* metrics);
+static void TextUpdateGeometry(Text* text);
+static void TextLayoutGlyphs(Text* text);
+static void TextRefreshLayout(Text* text);
+
+/*
+    Guards every glyph cache, the font list and the cached layouts of Text objects, text can be laid out
+    and drawn from any thread. Held while DrawText() records into the render queue, never the other way around.
+*/
+static std::mutex glyphCacheMutex;
+static Font* fontList = nullptr;
+
+// NOTE: FreeType only allows one thread at a time to create or destroy faces of a shared library
+static std::mutex ftLibraryMutex;
+static FT_Library ftLibrary = nullptr;
+
+// NOTE: The atlas cache is off while this is empty, font directories may be read only or shared
+static char fontCacheDirectory[FONT_CACHE_MAX_PATH] = { };
+
+void FontStartup()
 {
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
+    if (FT_Init_FreeType(&ftLibrary)) {
         LOG_ERROR("Could not init FreeType library");
-        return nullptr;
-    } else {
-        LOG_TRACE("FreeType initialized successfully");
+        ftLibrary = nullptr;
+        return;
     }
 
-    FT_Face face;
-    if (FT_New_Face(ft, filePath, 0, &face)) {
-        LOG_ERROR("Failed to load font '%s'", filePath);
-        return nullptr;
-    } else {
-        LOG_TRACE("Font '%s' loaded successfully", filePath);
-    }
+    LOG_TRACE("FreeType initialized successfully");
+}
 
-    Font* font = (Font*) SMalloc(sizeof(Font), MEMORY_TAG_FONT);
-    font->baseSize = baseSize;
-    font->glyphCount = 128;
-    font->glyphTable = (Glyph*) SMalloc(font->glyphCount * sizeof(Glyph), MEMORY_TAG_FONT);
+// NOTE: Fonts still loaded stay valid so the application can still unload them, only their faces are closed since
+// they belong to the library. Glyphs they don't have yet can't be rasterized anymore.
+void FontShutdown()
+{
+    std::lock_guard<std::mutex> glyphLock(glyphCacheMutex);
+    std::lock_guard<std::mutex> libraryLock(ftLibraryMutex);
+
+    if (fontList) {
+        LOG_WARN("FontShutdown: fonts are still loaded, unload them before closing the window");
+        for (Font* font = fontList; font; font = font->next) {
+            for (u32 thread = 0; thread < FONT_RASTER_MAX_THREADS; thread++) {
+                if (font->faces[thread]) {
+                    FT_Done_Face(font->faces[thread]);
+                    font->faces[thread] = nullptr;
+                }
+            }
+        }
+    }
 
-    FT_Set_Pixel_Sizes(face, 0, font->baseSize);
+    FT_Done_FreeType(ftLibrary);
+    ftLibrary = nullptr;
+}
 
-    for (i32 c = 0; c < font->glyphCount; c++) {
-        Glyph glyph = FontGetGlyph(face, (u8) c);
-        font->glyphTable[c] = glyph;
+/*
+    Turns on the atlas cache, baked atlases are stored in directory which should be per user, e.g. under the
+    user's cache or temp directory. Call it before loading fonts, nullptr turns the cache off again.
+*/
+void FontSetCacheDirectory(const char* directory)
+{
+    fontCacheDirectory[0] = '\0';
+    if (!directory || directory[0] == '\0') {
+        return;
     }
 
-    font->texture = FontGenerateFontAtlas(font->glyphTable, &font->texRects, font->glyphCount, font->baseSize);
-    if (!font->texture) {
-        FontUnload(&font);
-        LOG_ERROR("Failed to load font path: %s", face->family_name);
-        return nullptr;
+    u32 len = strlen(directory);
+    if (len + 2 > FONT_CACHE_MAX_PATH) {
+        LOG_ERROR("FontSetCacheDirectory: '%s' is too long", directory);
+        return;
     }
 
-    u32 len = strlen(face->family_name);
-    font->familyName = (char*) SMalloc(len + 1, MEMORY_TAG_STRING);
-    SMemCopy(font->familyName, face->family_name, len);
-    font->familyName[len] = '\0';
+    SMemCopy(fontCacheDirectory, directory, len);
+    if (directory[len - 1] != '/') {
+        fontCacheDirectory[len++] = '/';
+    }
+    fontCacheDirectory[len] = '\0';
+}
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+/*
+    SDF fonts store the distance to the glyph edge instead of coverage, so one atlas stays sharp at
+    every character size. A baseSize around 32 is enough for them.
+*/
+Font* FontLoadFromFile(const char* filePath, u32 baseSize, FontRenderMode renderMode)
+{
+    FontLoadInfo info = { filePath, baseSize, renderMode };
+    Font* font = nullptr;
+    FontLoadFromFiles(&info, 1, &font);
 
     return font;
 }
 
+/*
+    Loads several fonts at once. Every font is prepared on its own thread and the hardware threads left over
+    are split between the glyphs of each font. The atlases are uploaded on the calling thread, which owns the
+    GL context. outFonts[i] is null when infos[i] failed to load, returns the number of fonts loaded.
+    The atlas of every font is baked to disk once, later loads of the same file and base size skip FreeType.
+*/
+u32 FontLoadFromFiles(const FontLoadInfo* infos, u32 count, Font** outFonts)
+{
+    SASSERT_MSG(infos, "infos can't be null");
+    SASSERT_MSG(outFonts, "outFonts can't be null");
+    SASSERT_MSG(ftLibrary, "FreeType isn't initialized, fonts can only be loaded once the window is created");
+
+    if (count == 0) {
+        return 0;
+    }
+
+    u32 hardwareThreads = FontGetHardwareThreads();
+    u32 loaderCount = count < hardwareThreads ? count : hardwareThreads;
+    u32 threadsPerFont = hardwareThreads / loaderCount;
+
+    FontLoadState* states = (FontLoadState*) SMalloc(count * sizeof(FontLoadState), MEMORY_TAG_FONT);
+    auto load = [infos, count, outFonts, states, loaderCount, threadsPerFont](u32 loader) {
+        for (u32 i = loader; i < count; i += loaderCount) {
+            outFonts[i] = FontLoadPrepare(&infos[i], threadsPerFont, &states[i]);
+        }
+    };
+
+    std::thread loaders[FONT_RASTER_MAX_THREADS];
+    for (u32 loader = 1; loader < loaderCount; loader++) {
+        loaders[loader] = std::thread(load, loader);
+    }
+    load(0);
+    for (u32 loader = 1; loader < loaderCount; loader++) {
+        loaders[loader].join();
+    }
+
+    u32 loadedCount = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (!outFonts[i]) {
+            continue;
+        }
+
+        FontUploadBatch(outFonts[i], &states[i].batch, true);
+        if (!outFonts[i]->texture) {
+            LOG_ERROR("Failed to load font path: %s", infos[i].filePath);
+            FontUnload(&outFonts[i]);
+            continue;
+        }
+
+        if (!states[i].fromCache) {
+            FontCacheSave(outFonts[i], infos[i].filePath, states[i].fileHash);
+        }
+
+        std::lock_guard<std::mutex> lock(glyphCacheMutex);
+        outFonts[i]->next = fontList;
+        fontList = outFonts[i];
+        loadedCount++;
+    }
+    SFree(states);
+
+    return loadedCount;
+}
+
 void FontUnload(Font** font)
 {
     if (!font || !(*font)) {
         return;
     }
 
-    u32 glyphCount = (*font)->glyphCount;
-    for (u8 c = 0; c < glyphCount; c++) {
-        ImageUnload(&(*font)->glyphTable[c].bitmap);
+    {
+        std::lock_guard<std::mutex> lock(glyphCacheMutex);
+        for (Font** link = &fontList; *link; link = &(*link)->next) {
+            if (*link == *font) {
+                *link = (*font)->next;
+                break;
+            }
+        }
     }
 
+    GlyphCache* cache = (*font)->cache;
+    for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+        RectPackerDelete(&cache->pages[page].packer);
+    }
+    SFree(cache->codepoints);
+    SFree(cache->metrics);
+    SFree(cache->placements);
+    SFree(cache->slots);
+    SFree(cache->pending);
+    SFree(cache->atlasPixels);
+    SFree(cache);
+    SFree((*font)->kerning.keys);
+    SFree((*font)->kerning.adjustments);
+
     TextureUnload(&(*font)->texture);
+    {
+        std::lock_guard<std::mutex> lock(ftLibraryMutex);
+        for (u32 thread = 0; thread < FONT_RASTER_MAX_THREADS; thread++) {
+            if ((*font)->faces[thread]) {
+                FT_Done_Face((*font)->faces[thread]);
+            }
+        }
+    }
+    FileUnload((*font)->fileData);
     SFree((*font)->familyName);
-    SFree((*font)->glyphTable);
-    SFree((*font)->texRects);
     SFree(*font);
     *font = nullptr;
 }
@@ -114,98 +413,965 @@ u32 FontGetBaseSize(const Font* font)
     return font->baseSize;
 }
 
-static Texture2D* FontGenerateFontAtlas(Glyph* glyphs, Rectanglei** texRects, i32 glyphCount, u32 baseFontSize)
+FontRenderMode FontGetRenderMode(const Font* font)
 {
-    SASSERT_MSG(glyphs, "glyphs can't be null");
-    SASSERT_MSG(texRects, "texRects can't be null");
-    SASSERT_MSG(glyphCount > 0, "invalid glyph count");
+    SASSERT_MSG(font, "font can't be null");
+    return font->renderMode;
+}
 
-    // NOTE(Tony): Generate Squared power of 2 texture
-    // TODO(Tony): Pack Texture
-    i32 padding = 5;
-    u32 squareSize = 1;
-    u32 fontArea = glyphCount * (baseFontSize + padding) * (baseFontSize + padding);
-    for (u32 i = 0; i < 32 && ((squareSize * squareSize) < fontArea); i++) {
-        squareSize <<= 1;
+/*
+    Rasterizes the glyphs requested during the frame, called by RendererEndFrame() once the frame is flushed.
+    The work per font is capped so a burst of new text is spread over a few frames instead of stalling one.
+    Glyph quads recorded by worker threads that aren't part of the flushed frame keep the current atlas layout,
+    so while there are any the atlas neither grows nor evicts and glyphs that don't fit wait for a later frame.
+*/
+void FontUpdateGlyphCaches()
+{
+    std::lock_guard<std::mutex> lock(glyphCacheMutex);
+
+    // NOTE: Checked under the lock, text laid out by a worker thread afterwards already sees the new layout
+    bool8 canRepack = !RendererHasThreadCommands();
+    for (Font* font = fontList; font; font = font->next) {
+        GlyphBatch batch = { };
+        FontRasterizeBatch(font, FONT_GLYPH_FRAME_BUDGET, FontGetHardwareThreads(), &batch);
+        FontUploadBatch(font, &batch, canRepack);
+        font->cache->frame++;
     }
+}
 
-    u32 width = squareSize;
-    u32 height = squareSize;
+/*
+    Opens the font and rasterizes printable ASCII, which sizes the atlas pages, unless a baked atlas of the
+    same file is cached. Runs on a loader thread, the font isn't visible to other threads until it's published
+    so its cache needs no lock yet.
+*/
+static Font* FontLoadPrepare(const FontLoadInfo* info, u32 threadCount, FontLoadState* state)
+{
+    *state = FontLoadState{ };
+
+    u64 fileSize = 0;
+    u8* fileData = FileLoadBinary(info->filePath, &fileSize);
+    if (!fileData) {
+        LOG_ERROR("Failed to load font '%s'", info->filePath);
+        return nullptr;
+    }
+
+    FontRenderMode renderMode = info->renderMode;
+#if FREETYPE_MAJOR == 2 && FREETYPE_MINOR < 11
+    if (renderMode == FONT_RENDER_MODE_SDF) {
+        LOG_WARN("FreeType %d.%d has no SDF renderer, '%s' is loaded as a bitmap font",
+                 FREETYPE_MAJOR, FREETYPE_MINOR, info->filePath);
+        renderMode = FONT_RENDER_MODE_BITMAP;
+    }
+#endif
+
+    Font* font = (Font*) SMalloc(sizeof(Font), MEMORY_TAG_FONT);
+    font->baseSize = info->baseSize;
+    font->renderMode = renderMode;
+    font->fileData = fileData;
+    font->fileSize = fileSize;
+    font->cache = (GlyphCache*) SMalloc(sizeof(GlyphCache), MEMORY_TAG_FONT);
+
+    // NOTE: Faces are opened lazily, a font read from the cache doesn't touch FreeType until a glyph is missing
+    state->fileHash = fontCacheDirectory[0] != '\0' ? DataHash64(fileData, fileSize) : 0;
+    if (FontCacheLoad(font, info->filePath, state->fileHash)) {
+        LOG_TRACE("Font '%s' loaded from the atlas cache", info->filePath);
+        state->fromCache = true;
+        return font;
+    }
 
-    Texture2D* texture = TextureCreate((i32) width, (i32) height, MAGENTA);
-    TextureSetWrap(texture, TEXTURE_WRAP_MIRROR_CLAMP);
-    TextureSetFilter(texture, TEXTURE_FILTER_TRILINEAR);
+    FT_Face face = FontGetFace(font, 0);
+    if (!face) {
+        LOG_ERROR("Failed to load font '%s'", info->filePath);
+        FontUnload(&font);
+        return nullptr;
+    } else {
+        LOG_TRACE("Font '%s' loaded successfully", info->filePath);
+    }
 
-    *texRects = (Rectanglei*) SRealloc(*texRects, glyphCount * sizeof(Rectanglei), MEMORY_TAG_FONT);
+    u32 len = strlen(face->family_name);
+    font->familyName = (char*) SMalloc(len + 1, MEMORY_TAG_STRING);
+    SMemCopy(font->familyName, face->family_name, len);
+    font->familyName[len] = '\0';
+    font->ascender = (i32) face->size->metrics.ascender;
+    font->descender = (i32) face->size->metrics.descender;
+    FontLoadKerning(font, face);
 
-    i32 xOffset = 0;
-    i32 yOffset = 0;
-    for (i32 c = 0; c < glyphCount; c++) {
-        Glyph glyph = glyphs[c];
+    for (u32 c = 32; c < 127; c++) {
+        FontRequestGlyph(font, c);
+    }
+    FontRasterizeBatch(font, font->cache->pendingCount, threadCount, &state->batch);
 
-        if (xOffset + glyph.width + padding >= width) {
-            xOffset = 0;
-            yOffset += (i32) (baseFontSize + padding);
+    return font;
+}
+
+/*
+    Reads the atlas baked by an earlier run straight from the mapped file. Packers can't be serialized, so the
+    glyphs are packed again in the order the load packed them, which has to land every glyph where it's stored.
+    Nothing is written to the font unless the whole file checks out.
+*/
+static bool8 FontCacheLoad(Font* font, const char* filePath, u64 fileHash)
+{
+    if (fontCacheDirectory[0] == '\0') {
+        return false;
+    }
+
+    char cachePath[FONT_CACHE_MAX_PATH];
+    FontCacheGetPath(filePath, font->baseSize, font->renderMode, cachePath);
+
+    PlatformFileMapping mapping = { };
+    if (!PlatformFileMap(cachePath, &mapping)) {
+        return false;
+    }
+
+    FontCacheHeader header = { };
+    if (mapping.size >= sizeof(FontCacheHeader)) {
+        SMemCopy(&header, mapping.data, sizeof(FontCacheHeader));
+    }
+
+    u64 glyphSize = sizeof(u32) + sizeof(GlyphMetrics) + sizeof(GlyphPlacement);
+    u64 pageSize = (u64) header.pageWidth * (u64) header.pageHeight;
+    bool8 valid = header.magic == FONT_CACHE_MAGIC && header.version == FONT_CACHE_VERSION &&
+                  header.fileHash == fileHash && header.baseSize == font->baseSize &&
+                  header.renderMode == font->renderMode && header.pageWidth > 0 && header.pageHeight > 0 &&
+                  header.pageWidth <= FONT_ATLAS_MAX_PAGE_SIZE && header.pageHeight <= FONT_ATLAS_MAX_PAGE_SIZE &&
+                  mapping.size == sizeof(FontCacheHeader) + header.glyphCount * glyphSize + pageSize +
+                                  header.familyNameLength + header.kerningCount * (sizeof(u64) + sizeof(i16));
+    if (!valid) {
+        LOG_TRACE("'%s' Atlas cache is stale, the font is baked again", cachePath);
+        PlatformFileUnmap(&mapping);
+        return false;
+    }
+
+    u32 count = header.glyphCount;
+    const u8* data = mapping.data + sizeof(FontCacheHeader);
+    u32* codepoints = (u32*) SMalloc(count * sizeof(u32), MEMORY_TAG_FONT);
+    GlyphMetrics* metrics = (GlyphMetrics*) SMalloc(count * sizeof(GlyphMetrics), MEMORY_TAG_FONT);
+    GlyphPlacement* placements = (GlyphPlacement*) SMalloc(count * sizeof(GlyphPlacement), MEMORY_TAG_FONT);
+    SMemCopy(codepoints, data, count * sizeof(u32));
+    data += count * sizeof(u32);
+    SMemCopy(metrics, data, count * sizeof(GlyphMetrics));
+    data += count * sizeof(GlyphMetrics);
+    SMemCopy(placements, data, count * sizeof(GlyphPlacement));
+    data += count * sizeof(GlyphPlacement);
+
+    // NOTE: Same order as FontRasterizeBatch(), tallest first and in load order between equal heights
+    u64* keys = (u64*) SMalloc(2 * count * sizeof(u64), MEMORY_TAG_FONT);
+    u32* order = (u32*) SMalloc(2 * count * sizeof(u32), MEMORY_TAG_FONT);
+    u32 packedCount = 0;
+    for (u32 i = 0; i < count && valid; i++) {
+        valid = placements[i].page <= 0 && (placements[i].flags & GLYPH_FLAG_LOADED);
+        if (valid && placements[i].page == 0 && metrics[i].width > 0 && metrics[i].height > 0) {
+            keys[packedCount] = ~(u64) metrics[i].height;
+            order[packedCount] = i;
+            packedCount++;
+        }
+    }
+    RadixSort64(keys, order, keys + count, order + count, packedCount);
+
+    RectPacker* packer = RectPackerCreate(header.pageWidth, header.pageHeight);
+    for (u32 i = 0; i < packedCount && valid; i++) {
+        const GlyphMetrics* glyphMetrics = &metrics[order[i]];
+        const GlyphPlacement* placement = &placements[order[i]];
+        Rectanglei rect = { };
+        valid = RectPackerPack(packer, glyphMetrics->width + FONT_GLYPH_PADDING,
+                               glyphMetrics->height + FONT_GLYPH_PADDING, &rect) &&
+                rect.left == placement->left && rect.top == placement->top;
+    }
+
+    if (valid) {
+        GlyphCache* cache = font->cache;
+        for (u32 i = 0; i < count; i++) {
+            u32 glyphIndex = GlyphCacheInsert(cache, codepoints[i]);
+            cache->metrics[glyphIndex] = metrics[i];
+            cache->placements[glyphIndex] = placements[i];
+            cache->placements[glyphIndex].flags = GLYPH_FLAG_LOADED;
         }
-        SASSERT(xOffset < width);
-        SASSERT(yOffset + baseFontSize + padding < height);
 
-        (*texRects)[c].width = (i32) glyph.width;
-        (*texRects)[c].height = (i32) glyph.height;
-        (*texRects)[c].left = xOffset;
-        (*texRects)[c].top = yOffset;
+        FontCreatePages(cache, header.pageWidth, header.pageHeight);
+        RectPackerDelete(&cache->pages[0].packer);
+        cache->pages[0].packer = packer;
+        packer = nullptr;
 
-        if (glyph.bitmap) {
-            u8* bitmapPixels = ImageGetPixels(glyph.bitmap);
-            TextureUpdatePixels(texture, bitmapPixels, xOffset, yOffset, glyph.width, glyph.height);
+        for (i32 y = 0; y < cache->pageHeight; y++) {
+            SMemCopy(cache->atlasPixels + y * cache->atlasWidth, data + y * cache->pageWidth,
+                     (u32) cache->pageWidth);
+        }
+        FontMarkDirty(cache, 0, 0, 0, cache->pageWidth, cache->pageHeight);
+        data += pageSize;
+
+        font->familyName = (char*) SMalloc(header.familyNameLength + 1, MEMORY_TAG_STRING);
+        SMemCopy(font->familyName, data, header.familyNameLength);
+        font->familyName[header.familyNameLength] = '\0';
+        data += header.familyNameLength;
+        font->ascender = header.ascender;
+        font->descender = header.descender;
+
+        const u8* adjustments = data + header.kerningCount * sizeof(u64);
+        for (u32 i = 0; i < header.kerningCount; i++) {
+            u64 key = 0;
+            i16 adjustment = 0;
+            SMemCopy(&key, data + i * sizeof(u64), sizeof(u64));
+            SMemCopy(&adjustment, adjustments + i * sizeof(i16), sizeof(i16));
+            KerningTableInsert(&font->kerning, key, adjustment);
         }
+    } else {
+        LOG_WARN("'%s' Atlas cache doesn't match the packer, the font is baked again", cachePath);
+    }
+
+    RectPackerDelete(&packer);
+    SFree(codepoints);
+    SFree(metrics);
+    SFree(placements);
+    SFree(keys);
+    SFree(order);
+    PlatformFileUnmap(&mapping);
 
-        xOffset += (i32) (glyph.width + padding);
+    return valid;
+}
+
+/*
+    Bakes the atlas of a freshly loaded font to disk. Only atlases that fit the first page are cached, which is
+    every font right after loading since the page is sized for the load batch.
+    The cache is an optimization, a directory that can't be written only costs the bake on the next run.
+*/
+static void FontCacheSave(const Font* font, const char* filePath, u64 fileHash)
+{
+    const GlyphCache* cache = font->cache;
+    if (fontCacheDirectory[0] == '\0' || cache->pageCount != 1 || cache->evictions != 0) {
+        return;
+    }
+
+    FontCacheHeader header = { };
+    header.magic = FONT_CACHE_MAGIC;
+    header.version = FONT_CACHE_VERSION;
+    header.fileHash = fileHash;
+    header.baseSize = font->baseSize;
+    header.renderMode = font->renderMode;
+    header.ascender = font->ascender;
+    header.descender = font->descender;
+    header.pageWidth = cache->pageWidth;
+    header.pageHeight = cache->pageHeight;
+    header.glyphCount = cache->glyphCount;
+    header.familyNameLength = strlen(font->familyName);
+    header.kerningCount = font->kerning.count;
+
+    u32 count = cache->glyphCount;
+    u64 pageSize = (u64) cache->pageWidth * (u64) cache->pageHeight;
+    u64 size = sizeof(FontCacheHeader) + count * (sizeof(u32) + sizeof(GlyphMetrics) + sizeof(GlyphPlacement)) +
+               pageSize + header.familyNameLength + header.kerningCount * (sizeof(u64) + sizeof(i16));
+
+    u8* fileData = (u8*) SMalloc(size, MEMORY_TAG_FONT);
+    u8* data = fileData;
+    SMemCopy(data, &header, sizeof(FontCacheHeader));
+    data += sizeof(FontCacheHeader);
+    SMemCopy(data, cache->codepoints, count * sizeof(u32));
+    data += count * sizeof(u32);
+    SMemCopy(data, cache->metrics, count * sizeof(GlyphMetrics));
+    data += count * sizeof(GlyphMetrics);
+    SMemCopy(data, cache->placements, count * sizeof(GlyphPlacement));
+    data += count * sizeof(GlyphPlacement);
+
+    for (i32 y = 0; y < cache->pageHeight; y++) {
+        SMemCopy(data + y * cache->pageWidth, cache->atlasPixels + y * cache->atlasWidth, (u32) cache->pageWidth);
+    }
+    data += pageSize;
+    SMemCopy(data, font->familyName, header.familyNameLength);
+    data += header.familyNameLength;
+
+    u8* adjustments = data + header.kerningCount * sizeof(u64);
+    for (u32 slot = 0, pair = 0; slot < font->kerning.capacity; slot++) {
+        if (font->kerning.keys[slot]) {
+            SMemCopy(data + pair * sizeof(u64), &font->kerning.keys[slot], sizeof(u64));
+            SMemCopy(adjustments + pair * sizeof(i16), &font->kerning.adjustments[slot], sizeof(i16));
+            pair++;
+        }
     }
 
-    TextureGenerateMipmap(texture);
-    LOG_TRACE("FontAtlas created w:%d h:%d", width, height);
+    char cachePath[FONT_CACHE_MAX_PATH];
+    FontCacheGetPath(filePath, font->baseSize, font->renderMode, cachePath);
+    FILE* fp = fopen(cachePath, "wb");
+    if (fp) {
+        u64 written = fwrite(fileData, sizeof(u8), size, fp);
+        fclose(fp);
+        if (written == size) {
+            LOG_TRACE("'%s' Font atlas baked", cachePath);
+        } else {
+            LOG_TRACE("'%s' Font atlas couldn't be baked", cachePath);
+            remove(cachePath);
+        }
+    } else {
+        LOG_TRACE("'%s' Font atlas couldn't be baked, the cache directory isn't writable", cachePath);
+    }
+    SFree(fileData);
+}
+
+// NOTE: <cache directory><font name>_<base size>[_sdf]_<path hash>.sfc, the hash tells fonts with the same name apart
+static void FontCacheGetPath(const char* filePath, u32 baseSize, FontRenderMode renderMode, char* outPath)
+{
+    StringViewer name = FileGetFileNameNoExtension(filePath);
 
-    return texture;
+    snprintf(outPath, FONT_CACHE_MAX_PATH, "%s%.*s_%u%s_%08x.sfc", fontCacheDirectory, (i32) name.length, name.data,
+             baseSize, renderMode == FONT_RENDER_MODE_SDF ? "_sdf" : "", StringHash(filePath));
 }
 
-static Glyph FontGetGlyph(FT_Face face, u8 glyphID)
+/*
+    Faces can't be used by two threads at once, so every rasterizer thread has its own face of the font.
+    They are opened the first time a thread needs one, by the thread starting the rasterizers.
+*/
+static FT_Face FontGetFace(Font* font, u32 thread)
 {
-    Glyph glyph = { };
+    if (!font->faces[thread]) {
+        std::lock_guard<std::mutex> lock(ftLibraryMutex);
 
-    if (FT_Load_Char(face, glyphID, FT_LOAD_RENDER)) {
-        LOG_ERROR("Failed to load glyph(%u), '%s'", (u32) glyphID, face->family_name);
-        return glyph;
+        FT_Face face = nullptr;
+        if (!ftLibrary || FT_New_Memory_Face(ftLibrary, font->fileData, (FT_Long) font->fileSize, 0, &face)) {
+            return nullptr;
+        }
+        FT_Set_Pixel_Sizes(face, 0, font->baseSize);
+        font->faces[thread] = face;
     }
-    FT_Bitmap bitmap = face->glyph->bitmap;
 
-    glyph.width = bitmap.width;
-    glyph.height = bitmap.rows;
-    glyph.bearingX = face->glyph->bitmap_left;
-    glyph.bearingY = face->glyph->bitmap_top;
-    glyph.advance = face->glyph->advance.x;
+    return font->faces[thread];
+}
 
-    if (glyph.width && glyph.height) {
-        glyph.bitmap = ImageCreate((i32) glyph.width, (i32) glyph.height, WHITE);
+/*
+    Reads the kerning of every pair of codepoints from FONT_KERNING_FIRST_CODEPOINT to FONT_KERNING_LAST_CODEPOINT,
+    which covers the glyphs loaded with the font and Latin-1. Unfitted so it scales with the character size.
+    Only the kern table is read, fonts that only kern through GPOS have no pairs.
+*/
+static void FontLoadKerning(Font* font, FT_Face face)
+{
+    if (!FT_HAS_KERNING(face)) {
+        return;
     }
 
-    if (!glyph.bitmap) {
-        LOG_ERROR("Failed to load glyph(%u) , '%s'", (u32) glyphID, face->family_name);
-        return glyph;
+    u32 codepoints[FONT_KERNING_LAST_CODEPOINT - FONT_KERNING_FIRST_CODEPOINT + 1];
+    FT_UInt glyphIndices[FONT_KERNING_LAST_CODEPOINT - FONT_KERNING_FIRST_CODEPOINT + 1];
+    u32 count = 0;
+    for (u32 c = FONT_KERNING_FIRST_CODEPOINT; c <= FONT_KERNING_LAST_CODEPOINT; c++) {
+        FT_UInt glyphIndex = FT_Get_Char_Index(face, c);
+        if (glyphIndex) {
+            codepoints[count] = c;
+            glyphIndices[count] = glyphIndex;
+            count++;
+        }
     }
 
-    u8* pixels = bitmap.buffer;
-    u8* bitmapPixels = ImageGetPixels(glyph.bitmap);
-    for (u32 y = 0; y < glyph.height; ++y) {
-        for (u32 x = 0; x < glyph.width; ++x) {
-            // Fill alpha channel
-            const u64 index = x + y * glyph.width;
-            bitmapPixels[index * 4 + 3] = pixels[x];
+    for (u32 left = 0; left < count; left++) {
+        for (u32 right = 0; right < count; right++) {
+            FT_Vector kerning = { };
+            if (FT_Get_Kerning(face, glyphIndices[left], glyphIndices[right], FT_KERNING_UNFITTED, &kerning) ||
+                kerning.x == 0) {
+                continue;
+            }
+
+            u64 key = (u64) codepoints[left] << 32 | codepoints[right];
+            KerningTableInsert(&font->kerning, key, (i16) kerning.x);
         }
-        pixels += bitmap.pitch;
     }
 
-    return glyph;
+    LOG_TRACE("Font '%s' has %u kerning pairs", font->familyName, font->kerning.count);
+}
+
+// NOTE: Returns the adjustment between two codepoints in 1/64 pixels at the base size
+static i32 FontGetKerning(const Font* font, u32 left, u32 right)
+{
+    const KerningTable* table = &font->kerning;
+    if (table->count == 0) {
+        return 0;
+    }
+
+    u64 key = (u64) left << 32 | right;
+    u32 mask = table->capacity - 1;
+    for (u32 slot = (u32) ((key * 11400714819323198485ull) >> 32) & mask; table->keys[slot];
+         slot = (slot + 1) & mask) {
+        if (table->keys[slot] == key) {
+            return table->adjustments[slot];
+        }
+    }
+
+    return 0;
+}
+
+static void KerningTableInsert(KerningTable* table, u64 key, i16 adjustment)
+{
+    // NOTE: Kept at most half full like the glyph slots
+    if (2 * (table->count + 1) > table->capacity) {
+        KerningTable grown = { };
+        grown.capacity = table->capacity ? table->capacity * 2 : 64;
+        grown.keys = (u64*) SMalloc(grown.capacity * sizeof(u64), MEMORY_TAG_FONT);
+        grown.adjustments = (i16*) SMalloc(grown.capacity * sizeof(i16), MEMORY_TAG_FONT);
+        for (u32 slot = 0; slot < table->capacity; slot++) {
+            if (table->keys[slot]) {
+                KerningTableInsert(&grown, table->keys[slot], table->adjustments[slot]);
+            }
+        }
+
+        SFree(table->keys);
+        SFree(table->adjustments);
+        *table = grown;
+    }
+
+    u32 mask = table->capacity - 1;
+    u32 slot = (u32) ((key * 11400714819323198485ull) >> 32) & mask;
+    while (table->keys[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    table->keys[slot] = key;
+    table->adjustments[slot] = adjustment;
+    table->count++;
+}
+
+static u32 FontGetHardwareThreads()
+{
+    u32 threadCount = std::thread::hardware_concurrency();
+    if (threadCount > FONT_RASTER_MAX_THREADS) {
+        threadCount = FONT_RASTER_MAX_THREADS;
+    }
+
+    return threadCount ? threadCount : 1;
+}
+
+static u32 GlyphCacheFind(const GlyphCache* cache, u32 codepoint)
+{
+    if (cache->slotCapacity == 0) {
+        return FONT_GLYPH_NONE;
+    }
+
+    // NOTE: The multiplier is odd, consecutive codepoints land in distinct slots
+    u32 mask = cache->slotCapacity - 1;
+    for (u32 slot = (codepoint * 2654435761u) & mask; cache->slots[slot]; slot = (slot + 1) & mask) {
+        u32 glyphIndex = cache->slots[slot] - 1;
+        if (cache->codepoints[glyphIndex] == codepoint) {
+            return glyphIndex;
+        }
+    }
+
+    return FONT_GLYPH_NONE;
+}
+
+static u32 GlyphCacheInsert(GlyphCache* cache, u32 codepoint)
+{
+    // NOTE: The table is kept at most half full so probe chains stay short
+    if (2 * (cache->glyphCount + 1) > cache->slotCapacity) {
+        u32 slotCapacity = cache->slotCapacity ? cache->slotCapacity * 2 : 256;
+        SFree(cache->slots);
+        cache->slots = (u32*) SMalloc(slotCapacity * sizeof(u32), MEMORY_TAG_FONT);
+        cache->slotCapacity = slotCapacity;
+        for (u32 i = 0; i < cache->glyphCount; i++) {
+            GlyphCacheLink(cache, i);
+        }
+    }
+
+    if (cache->glyphCount == cache->glyphCapacity) {
+        u32 capacity = cache->glyphCapacity ? cache->glyphCapacity * 2 : 128;
+        cache->codepoints = (u32*) SRealloc(cache->codepoints, capacity * sizeof(u32), MEMORY_TAG_FONT);
+        cache->metrics = (GlyphMetrics*) SRealloc(cache->metrics, capacity * sizeof(GlyphMetrics), MEMORY_TAG_FONT);
+        cache->placements = (GlyphPlacement*) SRealloc(cache->placements, capacity * sizeof(GlyphPlacement),
+                                                       MEMORY_TAG_FONT);
+        cache->glyphCapacity = capacity;
+    }
+
+    u32 glyphIndex = cache->glyphCount++;
+    cache->codepoints[glyphIndex] = codepoint;
+    cache->metrics[glyphIndex] = GlyphMetrics{ };
+    cache->placements[glyphIndex] = GlyphPlacement{ 0, 0, -1, 0 };
+    GlyphCacheLink(cache, glyphIndex);
+
+    return glyphIndex;
+}
+
+// NOTE: Slots store the glyph index + 1, 0 marks an empty slot
+static void GlyphCacheLink(GlyphCache* cache, u32 glyphIndex)
+{
+    u32 mask = cache->slotCapacity - 1;
+    u32 slot = (cache->codepoints[glyphIndex] * 2654435761u) & mask;
+    while (cache->slots[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    cache->slots[slot] = glyphIndex + 1;
+}
+
+/*
+    Returns the cached glyph index of codepoint and queues the glyph for rasterization when it isn't in
+    the atlas. Expects glyphCacheMutex to be held.
+*/
+static u32 FontRequestGlyph(const Font* font, u32 codepoint)
+{
+    GlyphCache* cache = font->cache;
+    u32 glyphIndex = GlyphCacheFind(cache, codepoint);
+    if (glyphIndex == FONT_GLYPH_NONE) {
+        glyphIndex = GlyphCacheInsert(cache, codepoint);
+    }
+
+    const GlyphMetrics* metrics = &cache->metrics[glyphIndex];
+    GlyphPlacement* placement = &cache->placements[glyphIndex];
+    bool8 resident = (placement->flags & GLYPH_FLAG_LOADED) &&
+                     (placement->page >= 0 || metrics->width == 0 || metrics->height == 0);
+    if (!resident && !(placement->flags & GLYPH_FLAG_PENDING)) {
+        if (cache->pendingCount == cache->pendingCapacity) {
+            cache->pendingCapacity = cache->pendingCapacity ? cache->pendingCapacity * 2 : 128;
+            cache->pending = (u32*) SRealloc(cache->pending, cache->pendingCapacity * sizeof(u32), MEMORY_TAG_FONT);
+        }
+        cache->pending[cache->pendingCount++] = glyphIndex;
+        placement->flags |= GLYPH_FLAG_PENDING;
+    }
+
+    return glyphIndex;
+}
+
+/*
+    Takes up to budget queued glyphs off the queue and rasterizes them on at most threadCount threads,
+    each thread takes every threadCount-th glyph with its own face. Threads only pay off past a handful of
+    glyphs each, so small batches use fewer. Expects glyphCacheMutex to be held once the font is published.
+*/
+static void FontRasterizeBatch(Font* font, u32 budget, u32 threadCount, GlyphBatch* batch)
+{
+    GlyphCache* cache = font->cache;
+    u32 count = cache->pendingCount < budget ? cache->pendingCount : budget;
+    if (count == 0) {
+        return;
+    }
+
+    u32 usefulThreads = (count + FONT_RASTER_GLYPHS_PER_THREAD - 1) / FONT_RASTER_GLYPHS_PER_THREAD;
+    if (threadCount > usefulThreads) {
+        threadCount = usefulThreads;
+    }
+    // NOTE: Fonts read from the atlas cache have no face open yet, glyphs of a face that fails are left empty
+    for (u32 thread = 0; thread < threadCount; thread++) {
+        if (!FontGetFace(font, thread)) {
+            threadCount = thread ? thread : 1;
+        }
+    }
+
+    // NOTE: Threads only write the metrics of their own glyphs, flags are left to the calling thread
+    u8** bitmaps = (u8**) SMalloc(count * sizeof(u8*), MEMORY_TAG_FONT);
+    auto rasterize = [font, cache, bitmaps, count, threadCount](u32 thread) {
+        for (u32 i = thread; i < count; i += threadCount) {
+            u32 glyphIndex = cache->pending[i];
+            bitmaps[i] = FontRasterizeGlyph(font->faces[thread], font->renderMode, cache->codepoints[glyphIndex],
+                                            &cache->metrics[glyphIndex]);
+        }
+    };
+
+    std::thread rasterizers[FONT_RASTER_MAX_THREADS];
+    for (u32 thread = 1; thread < threadCount; thread++) {
+        rasterizers[thread] = std::thread(rasterize, thread);
+    }
+    rasterize(0);
+    for (u32 thread = 1; thread < threadCount; thread++) {
+        rasterizers[thread].join();
+    }
+
+    // NOTE: Packing tallest first keeps the skyline flat
+    u64* keys = (u64*) SMalloc(2 * count * sizeof(u64), MEMORY_TAG_FONT);
+    u32* order = (u32*) SMalloc(2 * count * sizeof(u32), MEMORY_TAG_FONT);
+    for (u32 i = 0; i < count; i++) {
+        cache->placements[cache->pending[i]].flags |= GLYPH_FLAG_LOADED;
+        keys[i] = ~(u64) cache->metrics[cache->pending[i]].height;
+        order[i] = i;
+    }
+    RadixSort64(keys, order, keys + count, order + count, count);
+
+    batch->glyphIndices = (u32*) SMalloc(count * sizeof(u32), MEMORY_TAG_FONT);
+    batch->bitmaps = (u8**) SMalloc(count * sizeof(u8*), MEMORY_TAG_FONT);
+    batch->count = count;
+    for (u32 i = 0; i < count; i++) {
+        batch->glyphIndices[i] = cache->pending[order[i]];
+        batch->bitmaps[i] = bitmaps[order[i]];
+    }
+
+    cache->pendingCount -= count;
+    SMemMove(cache->pending, cache->pending + count, cache->pendingCount * sizeof(u32));
+
+    SFree(bitmaps);
+    SFree(keys);
+    SFree(order);
+}
+
+/*
+    Packs a rasterized batch and composes it into the CPU copy of the atlas, the atlas is created by the first
+    batch unless it was read from the atlas cache. Every page the batch touched is then uploaded with one call and
+    the glyph bitmaps are freed. Has to run on the render thread, layouts missing one of the glyphs pick them up
+    through the cache generation. Without canRepack glyphs only go to the free space of the current page.
+*/
+static void FontUploadBatch(Font* font, GlyphBatch* batch, bool8 canRepack)
+{
+    GlyphCache* cache = font->cache;
+    if (batch->count == 0 && (font->texture || !cache->atlasPixels)) {
+        return;
+    }
+
+    if (cache->atlasPixels || FontCreateAtlas(font, batch->glyphIndices, batch->count)) {
+        for (u32 i = 0; i < batch->count; i++) {
+            u32 glyphIndex = batch->glyphIndices[i];
+            GlyphMetrics* metrics = &cache->metrics[glyphIndex];
+            const u8* bitmap = batch->bitmaps[i];
+            if (!bitmap) {
+                continue;
+            }
+
+            if ((i32) metrics->width + FONT_GLYPH_PADDING > cache->pageWidth ||
+                (i32) metrics->height + FONT_GLYPH_PADDING > cache->pageHeight) {
+                LOG_ERROR("FontAtlas: glyph(%u) %ux%u doesn't fit a %dx%d page, '%s'", cache->codepoints[glyphIndex],
+                          (u32) metrics->width, (u32) metrics->height, cache->pageWidth, cache->pageHeight,
+                          font->familyName);
+
+                // NOTE: Drawn as an empty advance, requesting it again would never succeed
+                metrics->width = 0;
+                metrics->height = 0;
+                continue;
+            }
+
+            // NOTE: Left off the atlas, the text missing it requests it again on a later frame
+            if (!FontPackGlyph(font, glyphIndex, canRepack)) {
+                continue;
+            }
+
+            const GlyphPlacement* placement = &cache->placements[glyphIndex];
+            u8* dst = cache->atlasPixels + placement->top * cache->atlasWidth + placement->left;
+            for (u32 y = 0; y < metrics->height; y++) {
+                SMemCopy(dst + y * cache->atlasWidth, bitmap + y * metrics->width, metrics->width);
+            }
+
+            const GlyphCachePage* page = &cache->pages[placement->page];
+            FontMarkDirty(cache, (u32) placement->page, placement->left - page->left, placement->top - page->top,
+                          metrics->width, metrics->height);
+        }
+
+        // NOTE: The texture keeps its identity when the atlas grew, draws already recorded with it stay valid
+        Vec2 textureSize = font->texture ? TextureGetSize(font->texture) : Vector2Zero();
+        if (!font->texture) {
+            FontCreateAtlasTexture(font);
+        } else if ((i32) textureSize.x != cache->atlasWidth || (i32) textureSize.y != cache->atlasHeight) {
+            TextureResize(font->texture, cache->atlasPixels, cache->atlasWidth, cache->atlasHeight);
+            FontClearDirty(cache);
+        } else {
+            FontUploadDirtyPages(font);
+        }
+
+        if (font->renderMode != FONT_RENDER_MODE_SDF) {
+            TextureGenerateMipmap(font->texture);
+        }
+    }
+
+    for (u32 i = 0; i < batch->count; i++) {
+        cache->placements[batch->glyphIndices[i]].flags &= (u8) ~GLYPH_FLAG_PENDING;
+        SFree(batch->bitmaps[i]);
+    }
+    cache->generation++;
+
+    SFree(batch->glyphIndices);
+    SFree(batch->bitmaps);
+    *batch = GlyphBatch{ };
+}
+
+/*
+    Sizes the atlas pages so the first batch of glyphs fits in one power of 2 page, the atlas starts with
+    that single page. glyphIndices are sorted tallest first.
+*/
+static bool8 FontCreateAtlas(Font* font, const u32* glyphIndices, u32 count)
+{
+    GlyphCache* cache = font->cache;
+
+    // NOTE: Even with a small first batch a page has to fit a few glyphs of the base size
+    i32 minSize = 2 * ((i32) font->baseSize + FONT_GLYPH_PADDING);
+    i32 width = 64;
+    while (width < minSize) {
+        width <<= 1;
+    }
+    i32 height = width;
+
+    u64 glyphArea = 0;
+    for (u32 i = 0; i < count; i++) {
+        const GlyphMetrics* metrics = &cache->metrics[glyphIndices[i]];
+        glyphArea += (u64) (metrics->width + FONT_GLYPH_PADDING) * (metrics->height + FONT_GLYPH_PADDING);
+    }
+
+    while ((u64) width * (u64) height < glyphArea) {
+        if (width <= height) {
+            width <<= 1;
+        } else {
+            height <<= 1;
+        }
+    }
+
+    RectPacker* packer = RectPackerCreate(width, height);
+    bool8 packed = false;
+    while (!packed && width <= FONT_ATLAS_MAX_PAGE_SIZE && height <= FONT_ATLAS_MAX_PAGE_SIZE) {
+        packed = true;
+        for (u32 i = 0; i < count && packed; i++) {
+            const GlyphMetrics* metrics = &cache->metrics[glyphIndices[i]];
+            Rectanglei rect = { };
+            packed = RectPackerPack(packer, metrics->width + FONT_GLYPH_PADDING,
+                                    metrics->height + FONT_GLYPH_PADDING, &rect);
+        }
+
+        if (!packed) {
+            if (width <= height) {
+                width <<= 1;
+            } else {
+                height <<= 1;
+            }
+            RectPackerDelete(&packer);
+            packer = RectPackerCreate(width, height);
+        }
+    }
+    RectPackerDelete(&packer);
+
+    if (!packed) {
+        LOG_ERROR("FontAtlas: glyphs don't fit in a %dx%d page", FONT_ATLAS_MAX_PAGE_SIZE, FONT_ATLAS_MAX_PAGE_SIZE);
+        return false;
+    }
+
+    FontCreatePages(cache, width, height);
+
+    return true;
+}
+
+// NOTE: Lays out the pages of the atlas and allocates the CPU copy of the first one
+static void FontCreatePages(GlyphCache* cache, i32 pageWidth, i32 pageHeight)
+{
+    cache->pageWidth = pageWidth;
+    cache->pageHeight = pageHeight;
+    for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+        cache->pages[page].packer = RectPackerCreate(pageWidth, pageHeight);
+        cache->pages[page].left = (i32) (page % FONT_ATLAS_PAGES_PER_SIDE) * pageWidth;
+        cache->pages[page].top = (i32) (page / FONT_ATLAS_PAGES_PER_SIDE) * pageHeight;
+    }
+    cache->pageCount = 1;
+    cache->currentPage = 0;
+
+    cache->atlasWidth = pageWidth;
+    cache->atlasHeight = pageHeight;
+    cache->atlasPixels = (u8*) SMalloc((u32) pageWidth * (u32) pageHeight, MEMORY_TAG_FONT);
+}
+
+/*
+    Resizes the CPU copy of the atlas to the pages in use, called when a page is opened. Pages keep their
+    position in the grid so placements stay valid, only the texture coordinates of laid out text change.
+*/
+static void FontGrowAtlas(GlyphCache* cache)
+{
+    u32 columns = cache->pageCount < FONT_ATLAS_PAGES_PER_SIDE ? cache->pageCount : FONT_ATLAS_PAGES_PER_SIDE;
+    u32 rows = (cache->pageCount + FONT_ATLAS_PAGES_PER_SIDE - 1) / FONT_ATLAS_PAGES_PER_SIDE;
+    i32 width = (i32) columns * cache->pageWidth;
+    i32 height = (i32) rows * cache->pageHeight;
+    if (width == cache->atlasWidth && height == cache->atlasHeight) {
+        return;
+    }
+
+    u8* pixels = (u8*) SMalloc((u32) width * (u32) height, MEMORY_TAG_FONT);
+    for (i32 y = 0; y < cache->atlasHeight; y++) {
+        SMemCopy(pixels + y * width, cache->atlasPixels + y * cache->atlasWidth, (u32) cache->atlasWidth);
+    }
+    SFree(cache->atlasPixels);
+
+    cache->atlasPixels = pixels;
+    cache->atlasWidth = width;
+    cache->atlasHeight = height;
+    cache->resizes++;
+}
+
+// NOTE: Needs the GL context, the texture is created from the CPU copy so nothing is left dirty
+static void FontCreateAtlasTexture(Font* font)
+{
+    GlyphCache* cache = font->cache;
+
+    // NOTE: R8 samples as transparent white, the padding doesn't bleed into filtered glyph edges
+    font->texture = TextureLoadFromMemory(cache->atlasPixels, cache->atlasWidth, cache->atlasHeight,
+                                          PIXEL_FORMAT_R8);
+    FontClearDirty(cache);
+    TextureSetWrap(font->texture, TEXTURE_WRAP_MIRROR_CLAMP);
+
+    // NOTE: Distances interpolate linearly, mipmaps would blur the edge of small text
+    if (font->renderMode == FONT_RENDER_MODE_SDF) {
+        TextureSetFilter(font->texture, TEXTURE_FILTER_BILINEAR);
+    } else {
+        TextureSetFilter(font->texture, TEXTURE_FILTER_TRILINEAR);
+    }
+
+    LOG_TRACE("FontAtlas created w:%d h:%d, grows up to %d pages of %dx%d (base size %u)",
+              cache->atlasWidth, cache->atlasHeight, FONT_ATLAS_PAGE_COUNT, cache->pageWidth, cache->pageHeight,
+              font->baseSize);
+}
+
+/*
+    Packs the glyph into the page being filled. When it's full the next page is opened, once every page
+    is in use the one drawn least recently is evicted and filled again. Opening a page can grow the atlas,
+    so without canRepack the glyph is only packed when the current page has room.
+
+    Pages drawn this frame or filled by this batch are never evicted, nor is the page being filled. When no
+    other page is left the glyph isn't packed and waits for a later frame.
+*/
+static bool8 FontPackGlyph(Font* font, u32 glyphIndex, bool8 canRepack)
+{
+    GlyphCache* cache = font->cache;
+    const GlyphMetrics* metrics = &cache->metrics[glyphIndex];
+    i32 width = metrics->width + FONT_GLYPH_PADDING;
+    i32 height = metrics->height + FONT_GLYPH_PADDING;
+
+    Rectanglei rect = { };
+    while (!RectPackerPack(cache->pages[cache->currentPage].packer, width, height, &rect)) {
+        if (!canRepack) {
+            return false;
+        }
+
+        if (cache->pageCount < FONT_ATLAS_PAGE_COUNT) {
+            cache->currentPage = cache->pageCount++;
+            FontGrowAtlas(cache);
+            continue;
+        }
+
+        u32 leastRecent = FONT_ATLAS_PAGE_COUNT;
+        for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+            if (page == cache->currentPage || cache->pages[page].lastUsedFrame >= cache->frame) {
+                continue;
+            }
+            if (leastRecent == FONT_ATLAS_PAGE_COUNT ||
+                cache->pages[page].lastUsedFrame < cache->pages[leastRecent].lastUsedFrame) {
+                leastRecent = page;
+            }
+        }
+        if (leastRecent == FONT_ATLAS_PAGE_COUNT) {
+            return false;
+        }
+
+        FontEvictPage(font, leastRecent);
+        cache->currentPage = leastRecent;
+    }
+
+    GlyphCachePage* page = &cache->pages[cache->currentPage];
+    page->lastUsedFrame = cache->frame;
+
+    GlyphPlacement* placement = &cache->placements[glyphIndex];
+    placement->left = (u16) (page->left + rect.left);
+    placement->top = (u16) (page->top + rect.top);
+    placement->page = (i8) cache->currentPage;
+
+    return true;
+}
+
+// NOTE: The page is cleared in the CPU copy of the atlas and uploaded with the rest of the batch
+static void FontEvictPage(Font* font, u32 page)
+{
+    GlyphCache* cache = font->cache;
+    for (u32 i = 0; i < cache->glyphCount; i++) {
+        if (cache->placements[i].page == (i8) page) {
+            cache->placements[i].page = -1;
+        }
+    }
+    RectPackerClear(cache->pages[page].packer);
+
+    u8* pixels = cache->atlasPixels + cache->pages[page].top * cache->atlasWidth + cache->pages[page].left;
+    for (i32 y = 0; y < cache->pageHeight; y++) {
+        SMemZero(pixels + y * cache->atlasWidth, (u32) cache->pageWidth);
+    }
+    FontMarkDirty(cache, page, 0, 0, cache->pageWidth, cache->pageHeight);
+
+    cache->evictions++;
+    LOG_TRACE("FontAtlas: evicted page %u of '%s'", page, font->familyName);
+}
+
+static void FontMarkDirty(GlyphCache* cache, u32 page, i32 left, i32 top, i32 width, i32 height)
+{
+    GlyphCachePage* cachePage = &cache->pages[page];
+    if (cachePage->dirtyRight <= cachePage->dirtyLeft) {
+        cachePage->dirtyLeft = left;
+        cachePage->dirtyTop = top;
+        cachePage->dirtyRight = left + width;
+        cachePage->dirtyBottom = top + height;
+        return;
+    }
+
+    cachePage->dirtyLeft = left < cachePage->dirtyLeft ? left : cachePage->dirtyLeft;
+    cachePage->dirtyTop = top < cachePage->dirtyTop ? top : cachePage->dirtyTop;
+    cachePage->dirtyRight = left + width > cachePage->dirtyRight ? left + width : cachePage->dirtyRight;
+    cachePage->dirtyBottom = top + height > cachePage->dirtyBottom ? top + height : cachePage->dirtyBottom;
+}
+
+static void FontClearDirty(GlyphCache* cache)
+{
+    for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+        cache->pages[page].dirtyLeft = 0;
+        cache->pages[page].dirtyTop = 0;
+        cache->pages[page].dirtyRight = 0;
+        cache->pages[page].dirtyBottom = 0;
+    }
+}
+
+// NOTE: Uploads the dirty rect of every page with a single call each, straight out of the CPU copy
+static void FontUploadDirtyPages(Font* font)
+{
+    GlyphCache* cache = font->cache;
+    i32 atlasWidth = cache->atlasWidth;
+
+    for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+        GlyphCachePage* cachePage = &cache->pages[page];
+        if (cachePage->dirtyRight <= cachePage->dirtyLeft) {
+            continue;
+        }
+
+        i32 left = cachePage->left + cachePage->dirtyLeft;
+        i32 top = cachePage->top + cachePage->dirtyTop;
+        u32 width = (u32) (cachePage->dirtyRight - cachePage->dirtyLeft);
+        u32 height = (u32) (cachePage->dirtyBottom - cachePage->dirtyTop);
+
+        const u8* pixels = cache->atlasPixels + (u32) (top * atlasWidth + left);
+        TextureUpdatePixels(font->texture, pixels, left, top, width, height, (u32) atlasWidth);
+
+        cachePage->dirtyLeft = 0;
+        cachePage->dirtyTop = 0;
+        cachePage->dirtyRight = 0;
+        cachePage->dirtyBottom = 0;
+    }
+}
+
+/*
+    Loads the metrics of the glyph and returns its coverage, one byte per pixel, or null when the glyph has
+    nothing to draw. Failed glyphs are left empty so they aren't requested again every frame.
+*/
+static u8* FontRasterizeGlyph(FT_Face face, FontRenderMode renderMode, u32 codepoint, GlyphMetrics* metrics)
+{
+    *metrics = GlyphMetrics{ };
+
+    if (!face) {
+        LOG_ERROR("Failed to load glyph(%u), the font face couldn't be opened", codepoint);
+        return nullptr;
+    }
+
+    FT_Int32 loadFlags = renderMode == FONT_RENDER_MODE_SDF ? FT_LOAD_DEFAULT : FT_LOAD_RENDER;
+    if (FT_Load_Char(face, codepoint, loadFlags)) {
+        LOG_ERROR("Failed to load glyph(%u), '%s'", codepoint, face->family_name);
+        return nullptr;
+    }
+
+#if FREETYPE_MAJOR > 2 || FREETYPE_MINOR >= 11
+    // NOTE: The distance field is rendered with a spread of 8 pixels around the outline, 128 is the edge
+    if (renderMode == FONT_RENDER_MODE_SDF && FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF)) {
+        LOG_ERROR("Failed to render SDF glyph(%u), '%s'", codepoint, face->family_name);
+        return nullptr;
+    }
+#endif
+    FT_Bitmap bitmap = face->glyph->bitmap;
+
+    metrics->bearingX = (i16) face->glyph->bitmap_left;
+    metrics->bearingY = (i16) face->glyph->bitmap_top;
+    metrics->advance = (u16) (face->glyph->advance.x >> 6);
+    if (bitmap.width == 0 || bitmap.rows == 0) {
+        return nullptr;
+    }
+    metrics->width = (u16) bitmap.width;
+    metrics->height = (u16) bitmap.rows;
+
+    u8* pixels = (u8*) SMalloc(bitmap.width * bitmap.rows, MEMORY_TAG_FONT);
+    const u8* row = bitmap.buffer;
+    for (u32 y = 0; y < bitmap.rows; y++) {
+        SMemCopy(pixels + y * bitmap.width, row, bitmap.width);
+        row += bitmap.pitch;
+    }
+
+    return pixels;
 }
 
 Text* TextCreate(const Font* font, Color color)
@@ -229,6 +1395,7 @@ void TextDelete(Text** text)
     }
 
     SFree((*text)->string);
+    SFree((*text)->vertices);
     SFree(*text);
     *text = nullptr;
 }
@@ -241,6 +1408,8 @@ void TextSetFont(Text* text, const Font* font)
     if (font) {
         text->characterSize = font->baseSize;
     }
+
+    TextUpdateGeometry(text);
 }
 
 const Font* TextGetFont(const Text* text)
@@ -252,7 +1421,9 @@ const Font* TextGetFont(const Text* text)
 void TextSetCharacterSize(Text* text, u32 size)
 {
     SASSERT_MSG(text, "text can't be null");
+
     text->characterSize = size;
+    TextUpdateGeometry(text);
 }
 
 u32 TextGetCharacterSize(const Text* text)
@@ -268,14 +1439,14 @@ void TextSetString(Text* text, const char* string)
     SFree(text->string);
     text->string = nullptr;
 
-    if (!string) {
-        return;
+    if (string) {
+        u64 size = strlen(string);
+        text->string = (char*) SMalloc(size + 1, MEMORY_TAG_STRING);
+        SMemCopy(text->string, string, size);
+        text->string[size] = '\0';
     }
 
-    u64 size = strlen(string);
-    text->string = (char*) SMalloc(size + 1, MEMORY_TAG_STRING);
-    SMemCopy(text->string, string, size);
-    text->string[size] = '\0';
+    TextUpdateGeometry(text);
 }
 
 void TextSetString(Text* text, StringViewer stringViewer)
@@ -285,13 +1456,13 @@ void TextSetString(Text* text, StringViewer stringViewer)
     SFree(text->string);
     text->string = nullptr;
 
-    if (!stringViewer.data || stringViewer.length <= 0) {
-        return;
+    if (stringViewer.data && stringViewer.length > 0) {
+        text->string = (char*) SMalloc(stringViewer.length, MEMORY_TAG_STRING);
+        SMemCopy(text->string, stringViewer.data, stringViewer.length - 1);
+        text->string[stringViewer.length - 1] = '\0';
     }
 
-    text->string = (char*) SMalloc(stringViewer.length, MEMORY_TAG_STRING);
-    SMemCopy(text->string, stringViewer.data, stringViewer.length - 1);
-    text->string[stringViewer.length - 1] = '\0';
+    TextUpdateGeometry(text);
 }
 
 const char* TextGetString(const Text* text)
@@ -303,7 +1474,11 @@ const char* TextGetString(const Text* text)
 void TextSetColor(Text* text, Color color)
 {
     SASSERT_MSG(text, "text can't be null");
+
     text->fillColor = color;
+    for (u32 i = 0; i < text->vertexCount; i++) {
+        text->vertices[i].color = color;
+    }
 }
 
 Color TextGetColor(const Text* text)
@@ -312,47 +1487,172 @@ Color TextGetColor(const Text* text)
     return text->fillColor;
 }
 
-void DrawText(const Text* text, Vec2 pos)
+/*
+    The bounds are measured while the text is laid out, so they are free until the string, font or character
+    size changes. width is the advance of the whole string kerning included, height spans the ascent and
+    descent of the font. Glyphs still being rasterized don't count until they are in the atlas.
+*/
+TextBounds TextGetBounds(const Text* text)
 {
     SASSERT_MSG(text, "text can't be null");
-    if (!text->font || !text->string) {
+    if (!text->font) {
+        return TextBounds{ };
+    }
+
+    std::lock_guard<std::mutex> lock(glyphCacheMutex);
+    TextRefreshLayout((Text*) text);
+
+    return text->bounds;
+}
+
+Vec2 TextMeasure(const Text* text)
+{
+    TextBounds bounds = TextGetBounds(text);
+    return Vec2{ bounds.width, bounds.height };
+}
+
+static void TextUpdateGeometry(Text* text)
+{
+    std::lock_guard<std::mutex> lock(glyphCacheMutex);
+    TextLayoutGlyphs(text);
+}
+
+/*
+    Lays out the quads of every glyph relative to the pen origin, the string is decoded as UTF-8 and the pen
+    is moved by the kerning of every pair. Glyphs that aren't in the atlas yet are requested and left out
+    until they're rasterized.
+    Expects glyphCacheMutex to be held.
+*/
+static void TextLayoutGlyphs(Text* text)
+{
+    SFree(text->vertices);
+    text->vertices = nullptr;
+    text->vertexCount = 0;
+    text->pageMask = 0;
+    text->bounds = TextBounds{ };
+    text->missingGlyphs = false;
+
+    if (!text->font) {
         return;
     }
-    SASSERT_MSG(text->font->glyphTable && text->font->texture && text->font->texture, "can't render broken font");
 
     f32 scale = (f32) text->characterSize / (f32) text->font->baseSize;
+    text->bounds.ascent = (f32) text->font->ascender / 64.0f * scale;
+    text->bounds.descent = (f32) -text->font->descender / 64.0f * scale;
+    text->bounds.height = text->bounds.ascent + text->bounds.descent;
+
+    if (!text->string || text->string[0] == '\0') {
+        return;
+    }
+    SASSERT_MSG(text->font->cache && text->font->texture, "can't render broken font");
+
+    const GlyphCache* cache = text->font->cache;
+    text->generation = cache->generation;
+    text->evictions = cache->evictions;
+    text->resizes = cache->resizes;
+
+    // NOTE: The atlas may have grown since the texture was last uploaded, texture coordinates follow the CPU copy
+    Vec2 textureSize = Vec2{ (f32) cache->atlasWidth, (f32) cache->atlasHeight };
+    Color color = text->fillColor;
+
+    // NOTE: Every codepoint takes at least one byte, the string length bounds the quad count
+    u32 length = strlen(text->string);
+    text->vertices = (Vertex*) SMalloc(6 * length * sizeof(Vertex), MEMORY_TAG_FONT);
+
+    Vec2 pos = Vector2Zero();
+    const char* s = text->string;
+    u32 previous = 0;
+    while (*s != '\0') {
+        u32 codepoint = 0;
+        s += UTF8Decode(s, &codepoint);
+        pos.x += (f32) FontGetKerning(text->font, previous, codepoint) / 64.0f * scale;
+        previous = codepoint;
+
+        u32 glyphIndex = FontRequestGlyph(text->font, codepoint);
+        const GlyphMetrics* metrics = &cache->metrics[glyphIndex];
+        const GlyphPlacement* placement = &cache->placements[glyphIndex];
+        if (!(placement->flags & GLYPH_FLAG_LOADED)) {
+            text->missingGlyphs = true;
+            continue;
+        }
 
-    Texture2D* texture = text->font->texture;
-    Vec2 textureSize = TextureGetSize(texture);
+        f32 xPos = pos.x + (f32) metrics->bearingX * scale;
+        f32 yPos = pos.y - (f32) metrics->bearingY * scale;
+        pos.x += (f32) metrics->advance * scale;
 
-    Vec4 colorNormalized = ColorNormalize(text->fillColor);
-    ShaderSetUniformVec4(*ShaderGetBound(), "uColor", colorNormalized);
+        if (metrics->width == 0 || metrics->height == 0) {
+            continue;
+        }
+
+        if (placement->page < 0) {
+            text->missingGlyphs = true;
+            continue;
+        }
+        text->pageMask |= 1u << placement->page;
+
+        f32 texCoordLeft = (f32) placement->left / (f32) textureSize.x;
+        f32 texCoordRight = (f32) (placement->left + metrics->width) / (f32) textureSize.x;
+        f32 texCoordTop = (f32) placement->top / (f32) textureSize.y;
+        f32 texCoordBottom = (f32) (placement->top + metrics->height) / (f32) textureSize.y;
+
+        f32 w = (f32) metrics->width * scale;
+        f32 h = (f32) metrics->height * scale;
+
+        Vertex* quad = text->vertices + text->vertexCount;
+        quad[0] = Vertex{ Vec2{ xPos, yPos + h }, Vec2{ texCoordLeft, texCoordBottom }, color };
+        quad[1] = Vertex{ Vec2{ xPos, yPos }, Vec2{ texCoordLeft, texCoordTop }, color };
+        quad[2] = Vertex{ Vec2{ xPos + w, yPos }, Vec2{ texCoordRight, texCoordTop }, color };
+        quad[3] = Vertex{ Vec2{ xPos, yPos + h }, Vec2{ texCoordLeft, texCoordBottom }, color };
+        quad[4] = Vertex{ Vec2{ xPos + w, yPos }, Vec2{ texCoordRight, texCoordTop }, color };
+        quad[5] = Vertex{ Vec2{ xPos + w, yPos + h }, Vec2{ texCoordRight, texCoordBottom }, color };
+        text->vertexCount += 6;
+    }
+    text->bounds.width = pos.x;
+}
+
+// NOTE: Rebuilds the layout when glyphs it was missing got rasterized or one of its pages was evicted
+static void TextRefreshLayout(Text* text)
+{
+    const GlyphCache* cache = text->font->cache;
+    if (text->evictions != cache->evictions || text->resizes != cache->resizes ||
+        (text->missingGlyphs && text->generation != cache->generation)) {
+        TextLayoutGlyphs(text);
+    }
+}
 
-    for (const char* s = text->string; *s != '\0'; s++) {
-        Glyph glyph = text->font->glyphTable[(u8) *s];
-        f32 xPos = pos.x + (f32) glyph.bearingX * scale;
-        f32 yPos = pos.y - (f32) glyph.bearingY * scale;
+/*
+    Records the cached glyph quads with a single draw, only the translation to pos is applied.
+    The layout is rebuilt first when glyphs it was missing got rasterized or one of its pages was evicted.
+    The lock is held until the quads are copied into the render queue, another thread drawing the same text
+    may rebuild its layout.
+*/
+void DrawText(const Text* text, Vec2 pos)
+{
+    SASSERT_MSG(text, "text can't be null");
+    if (!text->font) {
+        return;
+    }
 
-        Rectanglei texRect = text->font->texRects[(u8) *s];
-        f32 texCoordLeft = (f32) texRect.left / (f32) textureSize.x;
-        f32 texCoordRight = (f32) (texRect.left + texRect.width) / (f32) textureSize.x;
-        f32 texCoordTop = (f32) texRect.top / (f32) textureSize.y;
-        f32 texCoordBottom = (f32) (texRect.top + texRect.height) / (f32) textureSize.y;
+    std::lock_guard<std::mutex> lock(glyphCacheMutex);
 
-        f32 w = (f32) glyph.width * scale;
-        f32 h = (f32) glyph.height * scale;
+    // NOTE: Only the cached layout is rebuilt, nothing the caller can observe changes
+    TextRefreshLayout((Text*) text);
 
-        Vertex vertices[] = {
-            { Vec2{ xPos, yPos + h }, Vec2{ texCoordLeft, texCoordBottom } },
-            { Vec2{ xPos, yPos }, Vec2{ texCoordLeft, texCoordTop } },
-            { Vec2{ xPos + w, yPos }, Vec2{ texCoordRight, texCoordTop } },
-            { Vec2{ xPos, yPos + h }, Vec2{ texCoordLeft, texCoordBottom } },
-            { Vec2{ xPos + w, yPos }, Vec2{ texCoordRight, texCoordTop } },
-            { Vec2{ xPos + w, yPos + h }, Vec2{ texCoordRight, texCoordBottom } }
-        };
+    GlyphCache* cache = text->font->cache;
+    for (u32 page = 0; page < FONT_ATLAS_PAGE_COUNT; page++) {
+        if (text->pageMask & (1u << page)) {
+            cache->pages[page].lastUsedFrame = cache->frame;
+        }
+    }
 
-        RendererDraw(TRIANGLES, vertices, 6, texture, Matrix4Identity());
+    if (text->vertexCount == 0) {
+        return;
+    }
 
-        pos.x += (f32) (glyph.advance >> 6) * scale;
+    Mat4 transformMatrix = MatrixTranslate(Matrix4Identity(), Vec3{ pos.x, pos.y, 0.0f });
+    if (text->font->renderMode == FONT_RENDER_MODE_SDF) {
+        RendererDrawSDF(TRIANGLES, text->vertices, text->vertexCount, text->font->texture, transformMatrix);
+    } else {
+        RendererDraw(TRIANGLES, text->vertices, text->vertexCount, text->font->texture, transformMatrix);
     }
 }
\ No newline at end of file
@@ -5,14 +5,39 @@
 #include "srenderer.h"
 #include "utils/utils.h"
 
+typedef i32 FontRenderMode;
+
+enum SAPI FontRenderModes {
+    FONT_RENDER_MODE_BITMAP = 0,
+    FONT_RENDER_MODE_SDF
+};
+
 struct SAPI Font;
 struct SAPI Text;
 
-SAPI Font* FontLoadFromFile(const char* filePath, u32 baseSize = 48);
+// NOTE: Relative to the pen origin, ascent is above the baseline and descent below it, both positive
+struct SAPI TextBounds {
+    f32 width;
+    f32 height;
+    f32 ascent;
+    f32 descent;
+};
+
+struct SAPI FontLoadInfo {
+    const char* filePath;
+    u32 baseSize;
+    FontRenderMode renderMode;
+};
+
+SAPI Font* FontLoadFromFile(const char* filePath, u32 baseSize = 48,
+                            FontRenderMode renderMode = FONT_RENDER_MODE_BITMAP);
+SAPI u32 FontLoadFromFiles(const FontLoadInfo* infos, u32 count, Font** outFonts);
 SAPI void FontUnload(Font** font);
+SAPI void FontSetCacheDirectory(const char* directory);
 
 SAPI const char* FontGetFamilyName(const Font* font);
 SAPI u32 FontGetBaseSize(const Font* font);
+SAPI FontRenderMode FontGetRenderMode(const Font* font);
 
 SAPI Text* TextCreate(const Font* font, Color color = WHITE);
 SAPI void TextDelete(Text** text);
@@ -26,5 +51,7 @@ SAPI void TextSetString(Text* text, StringViewer stringViewer);
 SAPI const char* TextGetString(const Text* text);
 SAPI void TextSetColor(Text* text, Color color);
 SAPI Color TextGetColor(Text* text);
+SAPI TextBounds TextGetBounds(const Text* text);
+SAPI Vec2 TextMeasure(const Text* text);
 
 SAPI void DrawText(const Text* text, Vec2 pos);
\ No newline at end of file
@@ -22,6 +22,8 @@ struct Image {
     u8* pixels;
 };
 
+static void TextureUploadImage(const Texture2D* texture, const u8* pixels);
+
 Texture2D* TextureCreate(i32 width, i32 height, Color color)
 {
     Image* image = ImageCreate(width, height, color);
@@ -39,16 +41,21 @@ Texture2D* TextureCreate(i32 width, i32 height, Color color)
     return texture;
 }
 
-Texture2D* TextureLoadFromMemory(const u8* pixels, i32 width, i32 height)
+/*
+    R8 textures hold a single coverage channel, they sample as transparent white (1, 1, 1, red) so every shader
+    reads them like an RGBA8 texture with the coverage in alpha, at a quarter of the memory.
+*/
+Texture2D* TextureLoadFromMemory(const u8* pixels, i32 width, i32 height, PixelFormat format)
 {
     SASSERT_MSG(pixels, "pixels can't be null");
     SASSERT_MSG(width > 0 && height > 0, "invalid texture dimensions");
+    SASSERT_MSG(format == PIXEL_FORMAT_RGBA8 || format == PIXEL_FORMAT_R8, "Pixel format not supported!");
 
     Texture2D* texture = (Texture2D*) SMalloc(sizeof(Texture2D), MEMORY_TAG_TEXTURE);
 
     texture->width = width;
     texture->height = height;
-    texture->format = PIXEL_FORMAT_RGBA8;
+    texture->format = format;
     texture->mipmaps = 1;
 
     GLCall(glGenTextures(1, &texture->rendererID));
@@ -59,8 +66,11 @@ Texture2D* TextureLoadFromMemory(const u8* pixels, i32 width, i32 height)
 
     TextureBind(texture, 0);
 
-    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture->width, texture->height, 0,
-                        GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    if (format == PIXEL_FORMAT_R8) {
+        const GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+        GLCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+    }
+    TextureUploadImage(texture, pixels);
     TextureUnbind();
 
     return texture;
@@ -94,15 +104,72 @@ Texture2D* TextureLoadFromImage(const Image* image)
     return TextureLoadFromMemory(image->pixels, image->width, image->height);
 }
 
-void TextureUpdatePixels(Texture2D* texture, const u8* pixels, i32 xOffset, i32 yOffset, u32 width, u32 height)
+/*
+    pixels are in the format of the texture. rowLength is the distance between two rows of pixels in pixels,
+    0 when they are tightly packed, so a rect can be uploaded straight out of a bigger image.
+*/
+void TextureUpdatePixels(Texture2D* texture, const u8* pixels, i32 xOffset, i32 yOffset, u32 width, u32 height,
+                         u32 rowLength)
 {
     SASSERT_MSG(texture, "texture can't be null");
     SASSERT_MSG(pixels, "pixels can't be null");
     SASSERT_MSG(xOffset >= 0 && yOffset >= 0, "invalid texture offsets");
     SASSERT_MSG(width > 0 && height > 0, "invalid texture dimensions");
+    SASSERT_MSG(rowLength == 0 || rowLength >= width, "invalid row length");
+
+    RendererFlushTexture(texture);
+
+    GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) rowLength));
+    if (texture->format == PIXEL_FORMAT_R8) {
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        GLCall(glTextureSubImage2D(texture->rendererID, 0, xOffset, yOffset, width, height,
+                                   GL_RED, GL_UNSIGNED_BYTE, pixels));
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    } else {
+        GLCall(glTextureSubImage2D(texture->rendererID, 0, xOffset, yOffset, width, height,
+                                   GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    }
+    GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+}
+
+/*
+    Replaces the storage of the texture with pixels of the new size, in the format of the texture.
+    The texture keeps its filter and wrap modes and its mipmaps are generated again when it had any,
+    so draws still holding the texture stay valid.
+*/
+void TextureResize(Texture2D* texture, const u8* pixels, i32 width, i32 height)
+{
+    SASSERT_MSG(texture, "texture can't be null");
+    SASSERT_MSG(pixels, "pixels can't be null");
+    SASSERT_MSG(width > 0 && height > 0, "invalid texture dimensions");
+
+    RendererFlushTexture(texture);
+
+    texture->width = width;
+    texture->height = height;
+
+    TextureBind(texture, 0);
+    TextureUploadImage(texture, pixels);
+    TextureUnbind();
 
-    GLCall(glTextureSubImage2D(texture->rendererID, 0, xOffset, yOffset, width, height,
-                               GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    if (texture->mipmaps > 1) {
+        TextureGenerateMipmap(texture);
+    }
+}
+
+// NOTE: Expects the texture to be bound to slot 0
+static void TextureUploadImage(const Texture2D* texture, const u8* pixels)
+{
+    if (texture->format == PIXEL_FORMAT_R8) {
+        // NOTE: Rows of single byte pixels aren't 4 byte aligned
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, texture->width, texture->height, 0,
+                            GL_RED, GL_UNSIGNED_BYTE, pixels));
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    } else {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture->width, texture->height, 0,
+                            GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    }
 }
 
 void TextureUnload(Texture2D** texture)
@@ -111,6 +178,9 @@ void TextureUnload(Texture2D** texture)
         return;
     }
 
+    RendererReleaseTexture(*texture);
+
+    GLStateInvalidateTexture((*texture)->rendererID);
     GLCall(glDeleteTextures(1, &(*texture)->rendererID));
     SFree(*texture);
     *texture = nullptr;
@@ -120,13 +190,12 @@ void TextureBind(const Texture2D* texture, i32 slot)
 {
     SASSERT_MSG(texture, "texture can't be null");
 
-    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-    GLCall(glBindTexture(GL_TEXTURE_2D, texture->rendererID));
+    GLStateBindTexture(texture->rendererID, (u32) slot);
 }
 
 void TextureUnbind()
 {
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GLStateUnbindTexture();
 }
 
 Vec2 TextureGetSize(const Texture2D* texture)
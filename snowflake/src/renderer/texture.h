@@ -8,6 +8,7 @@ typedef i32 TextureWrap;
 
 enum SAPI PixelFormat {
     PIXEL_FORMAT_RGBA8 = 0,
+    PIXEL_FORMAT_R8
 };
 
 enum SAPI TextureFilters {
@@ -41,10 +42,13 @@ struct SAPI SubTexture2D {
 };
 
 SAPI Texture2D* TextureCreate(i32 width, i32 height, Color color);
-SAPI Texture2D* TextureLoadFromMemory(const u8* pixels, i32 width, i32 height);
+SAPI Texture2D* TextureLoadFromMemory(const u8* pixels, i32 width, i32 height,
+                                      PixelFormat format = PIXEL_FORMAT_RGBA8);
 SAPI Texture2D* TextureLoadFromFile(const char* filePath);
 SAPI Texture2D* TextureLoadFromImage(const Image* image);
-SAPI void TextureUpdatePixels(Texture2D* texture, const u8* pixels, i32 xOffset, i32 yOffset, u32 width, u32 height);
+SAPI void TextureUpdatePixels(Texture2D* texture, const u8* pixels, i32 xOffset, i32 yOffset, u32 width, u32 height,
+                              u32 rowLength = 0);
+SAPI void TextureResize(Texture2D* texture, const u8* pixels, i32 width, i32 height);
 SAPI void TextureUnload(Texture2D** texture);
 SAPI void TextureBind(const Texture2D* texture, i32 slot);
 SAPI void TextureUnbind();
@@ -8,6 +8,7 @@
 #include "utils/utils.h"
 
 #include "core/swindow.h"
+#include "renderer/rect_packer.h"
 #include "renderer/shapes.h"
 #include "renderer/srenderer.h"
 #include "renderer/stext.h"
\ No newline at end of file
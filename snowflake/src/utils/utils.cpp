@@ -5,6 +5,116 @@
 #include <cstdio>
 #include <cstring>
 
+// NOTE: 64-bit FNV-1a, used to tell whether a file changed since something was derived from it
+u64 DataHash64(const void* data, u64 size)
+{
+    const u8* bytes = (const u8*) data;
+    u64 hash = 14695981039346656037ull;
+    for (u64 i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/*
+    Stable LSD radix sort of 64-bit keys and their values, one pass per byte.
+    Passes where every key has the same byte are skipped, the temporary arrays must hold count elements.
+*/
+void RadixSort64(u64* keys, u32* values, u64* tmpKeys, u32* tmpValues, u32 count)
+{
+    if (count < 2) {
+        return;
+    }
+
+    u64* srcKeys = keys;
+    u32* srcValues = values;
+    u64* dstKeys = tmpKeys;
+    u32* dstValues = tmpValues;
+
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        u32 offsets[256] = { };
+        for (u32 i = 0; i < count; i++) {
+            offsets[(srcKeys[i] >> shift) & 0xFF]++;
+        }
+
+        if (offsets[(srcKeys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        u32 offset = 0;
+        for (u32 digit = 0; digit < 256; digit++) {
+            u32 digitCount = offsets[digit];
+            offsets[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            u32 index = offsets[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[index] = srcKeys[i];
+            dstValues[index] = srcValues[i];
+        }
+
+        u64* swapKeys = srcKeys;
+        srcKeys = dstKeys;
+        dstKeys = swapKeys;
+
+        u32* swapValues = srcValues;
+        srcValues = dstValues;
+        dstValues = swapValues;
+    }
+
+    if (srcKeys != keys) {
+        SMemCopy(keys, srcKeys, count * sizeof(u64));
+        SMemCopy(values, srcValues, count * sizeof(u32));
+    }
+}
+
+/*
+    Decodes the UTF-8 sequence at the start of string and returns its length in bytes.
+    Malformed sequences decode to U+FFFD and consume a single byte, so a decoding loop always advances.
+*/
+u32 UTF8Decode(const char* string, u32* outCodepoint)
+{
+    const u8* bytes = (const u8*) string;
+    u32 codepoint = 0xFFFD;
+    u32 length = 1;
+
+    if (bytes[0] < 0x80) {
+        codepoint = bytes[0];
+    } else if ((bytes[0] & 0xE0) == 0xC0) {
+        if ((bytes[1] & 0xC0) == 0x80) {
+            u32 value = ((bytes[0] & 0x1Fu) << 6) | (bytes[1] & 0x3Fu);
+            if (value >= 0x80) {
+                codepoint = value;
+                length = 2;
+            }
+        }
+    } else if ((bytes[0] & 0xF0) == 0xE0) {
+        if ((bytes[1] & 0xC0) == 0x80 && (bytes[2] & 0xC0) == 0x80) {
+            u32 value = ((bytes[0] & 0x0Fu) << 12) | ((bytes[1] & 0x3Fu) << 6) | (bytes[2] & 0x3Fu);
+            // NOTE: Overlong encodings and UTF-16 surrogates are rejected
+            if (value >= 0x800 && (value < 0xD800 || value > 0xDFFF)) {
+                codepoint = value;
+                length = 3;
+            }
+        }
+    } else if ((bytes[0] & 0xF8) == 0xF0) {
+        if ((bytes[1] & 0xC0) == 0x80 && (bytes[2] & 0xC0) == 0x80 && (bytes[3] & 0xC0) == 0x80) {
+            u32 value = ((bytes[0] & 0x07u) << 18) | ((bytes[1] & 0x3Fu) << 12) |
+                        ((bytes[2] & 0x3Fu) << 6) | (bytes[3] & 0x3Fu);
+            if (value >= 0x10000 && value <= 0x10FFFF) {
+                codepoint = value;
+                length = 4;
+            }
+        }
+    }
+
+    *outCodepoint = codepoint;
+    return length;
+}
+
 char* FileLoad(const char* filePath)
 {
     char* data = nullptr;
@@ -52,7 +162,7 @@ char* FileLoad(const char* filePath)
     return data;
 }
 
-u8* FileLoadBinary(const char* filePath)
+u8* FileLoadBinary(const char* filePath, u64* outSize)
 {
     u8* data = nullptr;
     FILE* fp = fopen(filePath, "rb");
@@ -93,6 +203,10 @@ u8* FileLoadBinary(const char* filePath)
 
         fclose(fp);
         LOG_TRACE("'%s' File loaded successfully", filePath);
+
+        if (outSize) {
+            *outSize = (u64) bufSize;
+        }
     }
 
     return data;
@@ -7,8 +7,24 @@ struct SAPI StringViewer {
     u32 length;
 };
 
+// NOTE: 32-bit FNV-1a, constexpr so literals can be hashed at compile time
+static constexpr u32 StringHash(const char* string)
+{
+    u32 hash = 2166136261u;
+    for (; *string != '\0'; string++) {
+        hash ^= (u8) *string;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+SAPI u64 DataHash64(const void* data, u64 size);
+SAPI void RadixSort64(u64* keys, u32* values, u64* tmpKeys, u32* tmpValues, u32 count);
+SAPI u32 UTF8Decode(const char* string, u32* outCodepoint);
+
 SAPI char* FileLoad(const char* filePath);
-SAPI u8* FileLoadBinary(const char* filePath);
+SAPI u8* FileLoadBinary(const char* filePath, u64* outSize = nullptr);
 SAPI void FileUnload(void* data);
 
 SAPI StringViewer FileGetExtension(const char* filePath);
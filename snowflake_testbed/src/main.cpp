@@ -3,6 +3,10 @@
 #include "snowflake.h"
 
 #include <cstdio>
+#include <thread>
+
+static bool8 threadedDrawing = false;
+static bool8 bakedDrawing = false;
 
 static void TestInput();
 static void TestPrimitiveShapes();
@@ -24,14 +28,28 @@ int main()
         // Handle error
     }
 
-    Font* font = FontLoadFromFile("../resources/IBMPlexSans-Regular.ttf", 48);
-    if (!font) {
+    // NOTE: One SDF atlas stays sharp at any size, the title is drawn at twice its base size
+    FontLoadInfo fontInfos[] = {
+        { "../resources/IBMPlexSans-Regular.ttf", 48, FONT_RENDER_MODE_BITMAP },
+        { "../resources/IBMPlexSans-Regular.ttf", 32, FONT_RENDER_MODE_SDF },
+    };
+    Font* fonts[ARRAYCOUNT(fontInfos)] = { };
+    if (FontLoadFromFiles(fontInfos, ARRAYCOUNT(fontInfos), fonts) != ARRAYCOUNT(fontInfos)) {
         // Handle error
     }
+    Font* font = fonts[0];
+    Font* sdfFont = fonts[1];
+
+    // NOTE: The map never changes, it's recorded once and redrawn from the GPU
+    BakedLayer* mapLayer = BakedLayerCreate();
 
     Text* testText = TextCreate(font);
     TextSetString(testText, "Potato Man Strikes Again");
 
+    Text* sdfText = TextCreate(sdfFont);
+    TextSetString(sdfText, "Snowflake");
+    TextSetCharacterSize(sdfText, 64);
+
     LOG_INFO(SMemUsage());
 
     while (!WindowShouldClose()) {
@@ -41,25 +59,53 @@ int main()
         {
             const u32 titleLen = 512;
             char title[titleLen] = { };
-            snprintf(title, titleLen, "WinPos:(X:%g, Y:%g) | MPos:(X:%g, Y:%g) | FTime:'%.1f'ms | FPS:%u",
+            RendererStats stats = RendererGetStats();
+            snprintf(title, titleLen, "WinPos:(X:%g, Y:%g) | MPos:(X:%g, Y:%g) | FTime:'%.1f'ms | FPS:%u"
+                                      " | Draws:%u | States:%u (Elided:%u) | Culled:%u/%u",
                      GetWindowPosition().x, GetWindowPosition().y,
                      GetMousePosition().x, GetMousePosition().y,
-                     GetFrameTime() * 1000, GetFPS());
+                     GetFrameTime() * 1000, GetFPS(),
+                     stats.drawCalls, stats.stateChanges, stats.elidedStateChanges,
+                     stats.culledPrimitives, stats.culledPrimitives + stats.submittedPrimitives);
             SetWindowTitle(title);
         }
 
         TestInput();
 //        TestPrimitiveShapes();
-        TestTextureDrawing(tex);
+        if (bakedDrawing) {
+            if (BakedLayerIsDirty(mapLayer)) {
+                BakedLayerBegin(mapLayer);
+                TestTextureDrawing(tex);
+                BakedLayerEnd(mapLayer);
+            }
+            BakedLayerDraw(mapLayer, Matrix4Identity());
+        } else if (threadedDrawing) {
+            // NOTE: The worker only records draws, they are submitted with the frame at EndDrawing()
+            std::thread worker([tex]() {
+                TestTextureDrawing(tex);
+                RendererSubmitThreadCommands();
+            });
+            worker.join();
+        } else {
+            TestTextureDrawing(tex);
+        }
 
+        // NOTE: Text is drawn on top of the map no matter where it's issued
+        RendererSetLayer(1);
         DrawText(testText, Vec2{ 100, 100 });
+        // NOTE: Right aligned with the text above
+        DrawText(sdfText, Vec2{ 100 + TextMeasure(testText).x - TextMeasure(sdfText).x, 200 });
+        RendererSetLayer(0);
 
         EndDrawing();
         PollInputEvents();
     }
 
+    BakedLayerDelete(&mapLayer);
+    TextDelete(&sdfText);
     TextDelete(&testText);
     TextureUnload(&tex);
+    FontUnload(&sdfFont);
     FontUnload(&font);
 
     CloseWindow();
@@ -77,6 +123,15 @@ static void TestInput()
     if (IsKeyPressed(KEY_3)) {
         RendererSetPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
     }
+    if (IsKeyPressed(KEY_4)) {
+        RendererSetInstancing(!RendererIsInstancingActive());
+    }
+    if (IsKeyPressed(KEY_5)) {
+        threadedDrawing = !threadedDrawing;
+    }
+    if (IsKeyPressed(KEY_6)) {
+        bakedDrawing = !bakedDrawing;
+    }
     if (IsKeyReleased(KEY_1)) {
         LOG_DEBUG("'%d' Key is Released", KEY_1);
     }
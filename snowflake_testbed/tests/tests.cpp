@@ -72,4 +72,96 @@ TEST_CASE("Math Functions", "[MATH]")
     REQUIRE(Abs(-2.0f) == 2.0f);
     REQUIRE(Square(-2) == 4);
     REQUIRE(Square(-2.0f) == 4.0f);
-}
\ No newline at end of file
+
+    Vec2 minVec = Vector2Min(Vec2{ 1.0f, -3.0f }, Vec2{ -2.0f, 4.0f });
+    Vec2 maxVec = Vector2Max(Vec2{ 1.0f, -3.0f }, Vec2{ -2.0f, 4.0f });
+    REQUIRE((minVec.x == -2.0f && minVec.y == -3.0f));
+    REQUIRE((maxVec.x == 1.0f && maxVec.y == 4.0f));
+}
+
+TEST_CASE("String Hash", "[UTILS]")
+{
+    constexpr u32 compileTimeHash = StringHash("uMvp");
+    STATIC_ASSERT(compileTimeHash == StringHash("uMvp"));
+
+    const char* uniformName = "uMvp";
+    REQUIRE(StringHash(uniformName) == compileTimeHash);
+    REQUIRE(StringHash("uMvp") != StringHash("uColor"));
+    REQUIRE(StringHash("") == 2166136261u);
+
+    REQUIRE(DataHash64("", 0) == 14695981039346656037ull);
+    REQUIRE(DataHash64("a", 1) == 0xAF63DC4C8601EC8Cull);
+    REQUIRE(DataHash64("ab", 2) != DataHash64("ba", 2));
+}
+
+TEST_CASE("Radix Sort", "[UTILS]")
+{
+    u64 keys[] = { 0x0100000000000002, 7, 0x0100000000000002, 0, 0xFF00000000000000, 7 };
+    u32 values[] = { 0, 1, 2, 3, 4, 5 };
+    u64 tmpKeys[ARRAYCOUNT(keys)] = { };
+    u32 tmpValues[ARRAYCOUNT(values)] = { };
+
+    RadixSort64(keys, values, tmpKeys, tmpValues, ARRAYCOUNT(keys));
+
+    u64 sortedKeys[] = { 0, 7, 7, 0x0100000000000002, 0x0100000000000002, 0xFF00000000000000 };
+    u32 sortedValues[] = { 3, 1, 5, 0, 2, 4 };
+    for (u32 i = 0; i < ARRAYCOUNT(keys); i++) {
+        REQUIRE(keys[i] == sortedKeys[i]);
+        REQUIRE(values[i] == sortedValues[i]);
+    }
+}
+
+TEST_CASE("UTF-8 Decode", "[UTILS]")
+{
+    u32 codepoint = 0;
+    REQUIRE(UTF8Decode("A", &codepoint) == 1);
+    REQUIRE(codepoint == 'A');
+    REQUIRE(UTF8Decode("\xC3\xA9", &codepoint) == 2);
+    REQUIRE(codepoint == 0xE9);
+    REQUIRE(UTF8Decode("\xE2\x82\xAC", &codepoint) == 3);
+    REQUIRE(codepoint == 0x20AC);
+    REQUIRE(UTF8Decode("\xF0\x9F\x98\x80", &codepoint) == 4);
+    REQUIRE(codepoint == 0x1F600);
+
+    // Truncated, overlong and surrogate sequences
+    REQUIRE(UTF8Decode("\xE2\x82", &codepoint) == 1);
+    REQUIRE(codepoint == 0xFFFD);
+    REQUIRE(UTF8Decode("\xC0\xAF", &codepoint) == 1);
+    REQUIRE(codepoint == 0xFFFD);
+    REQUIRE(UTF8Decode("\xED\xA0\x80", &codepoint) == 1);
+    REQUIRE(codepoint == 0xFFFD);
+}
+
+TEST_CASE("Rect Packer", "[RENDERER]")
+{
+    RectPacker* packer = RectPackerCreate(64, 64);
+
+    Rectanglei rects[16] = { };
+    for (u32 i = 0; i < ARRAYCOUNT(rects); i++) {
+        REQUIRE(RectPackerPack(packer, 16, 8 + (i % 3) * 4, &rects[i]));
+        REQUIRE((rects[i].left >= 0 && rects[i].left + rects[i].width <= 64));
+        REQUIRE((rects[i].top >= 0 && rects[i].top + rects[i].height <= 64));
+    }
+
+    for (u32 i = 0; i < ARRAYCOUNT(rects); i++) {
+        for (u32 j = i + 1; j < ARRAYCOUNT(rects); j++) {
+            bool8 overlapX = rects[i].left < rects[j].left + rects[j].width &&
+                             rects[j].left < rects[i].left + rects[i].width;
+            bool8 overlapY = rects[i].top < rects[j].top + rects[j].height &&
+                             rects[j].top < rects[i].top + rects[i].height;
+            REQUIRE(!(overlapX && overlapY));
+        }
+    }
+
+    Rectanglei rect = { };
+    REQUIRE(!RectPackerPack(packer, 65, 1, &rect));
+    REQUIRE(RectPackerGetUsedHeight(packer) <= 64);
+
+    RectPackerClear(packer);
+    REQUIRE(RectPackerPack(packer, 64, 64, &rect));
+    REQUIRE((rect.left == 0 && rect.top == 0));
+    REQUIRE(!RectPackerPack(packer, 1, 1, &rect));
+
+    RectPackerDelete(&packer);
+    REQUIRE(packer == nullptr);
+}